@@ -0,0 +1,69 @@
+#include "arena.h"
+#include <stdio.h>
+#include <string.h>
+
+void arena_init(Arena* a, void* memory, size_t size) {
+    // start on an ARENA_ALIGN boundary, pushes are rounded up so they stay on one
+    size_t skew = (ARENA_ALIGN - ((uintptr_t)memory & (ARENA_ALIGN - 1))) & (ARENA_ALIGN - 1);
+    a->base = (uint8_t*)memory + skew;
+    a->size = size > skew ? (size - skew) & ~(size_t)(ARENA_ALIGN - 1) : 0;
+    a->used = 0;
+}
+
+void* arena_push(Arena* a, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (size > a->size - a->used) {
+        printf("Error_arena: %zu bytes requested, %zu of %zu left\n", size, a->size - a->used, a->size);
+        return NULL;
+    }
+    void* p = a->base + a->used;
+    a->used += size;
+    memset(p, 0, size);
+    return p;
+}
+
+void arena_reset(Arena* a) {
+    a->used = 0;
+}
+
+//::allocation counter
+
+static SDL_malloc_func real_malloc;
+static SDL_calloc_func real_calloc;
+static SDL_realloc_func real_realloc;
+static SDL_free_func real_free;
+static SDL_ThreadID counted_thread;
+static SDL_AtomicInt allocations;
+
+static void count(void) {
+    if (SDL_GetCurrentThreadID() == counted_thread) SDL_AddAtomicInt(&allocations, 1);
+}
+
+static void* counting_malloc(size_t size) {
+    count();
+    return real_malloc(size);
+}
+
+static void* counting_calloc(size_t n, size_t size) {
+    count();
+    return real_calloc(n, size);
+}
+
+static void* counting_realloc(void* mem, size_t size) {
+    count();
+    return real_realloc(mem, size);
+}
+
+bool alloc_count_install(void) {
+    SDL_GetOriginalMemoryFunctions(&real_malloc, &real_calloc, &real_realloc, &real_free);
+    counted_thread = SDL_GetCurrentThreadID();
+    if (!SDL_SetMemoryFunctions(counting_malloc, counting_calloc, counting_realloc, real_free)) {
+        printf("Error_alloc_count: %s\n", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+uint32_t alloc_count(void) {
+    return (uint32_t)SDL_GetAtomicInt(&allocations);
+}
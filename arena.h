@@ -0,0 +1,28 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <SDL3/SDL.h>
+
+#define ARENA_ALIGN 16
+// bytes to reserve for an arena that must fit n bytes of pushes
+#define ARENA_BYTES(n) ((n) + 2 * ARENA_ALIGN)
+
+// bump allocator over a caller-owned block (static storage in main.c, so a session never
+// touches the heap). Everything is pushed once at startup and dropped together by arena_reset()
+typedef struct {
+    uint8_t* base;
+    size_t size;
+    size_t used;
+} Arena;
+
+void arena_init(Arena* a, void* memory, size_t size);
+// zeroed and ARENA_ALIGN aligned, NULL (with a message) when the arena is full
+void* arena_push(Arena* a, size_t size);
+void arena_reset(Arena* a);
+
+// counts SDL_malloc/calloc/realloc calls (SDL and SDL_ttf route every allocation through
+// them) made on the thread that installed the counter; call before SDL_Init
+bool alloc_count_install(void);
+uint32_t alloc_count(void);
+
+#endif
@@ -0,0 +1,332 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "sim.h"
+#include "bot.h"
+#include "level.h"
+
+#define BATCH_MAX_THREADS 256
+#define SCORE_BIN 16
+#define SCORE_BINS ((MAX_SCORE / SCORE_BIN) + 2)
+#define DURATION_BIN 30
+#define DURATION_BINS 41
+#define HIST_BAR_WIDTH 50
+
+typedef struct {
+    long long games;
+    long long cleared;
+    long long unfinished;
+    long long ticks;
+    long long total_score;
+    int min_score;
+    int max_score;
+    double total_seconds;
+    long long score_hist[SCORE_BINS];
+    long long duration_hist[DURATION_BINS];
+    long long lives_hist[MAX_LIVES + 1];
+} BatchStats;
+
+// per-worker job deque: the owner pops from the back, thieves take from the front
+typedef struct {
+    pthread_mutex_t lock;
+    int* jobs;
+    int head;
+    int tail;
+} JobQueue;
+
+typedef struct {
+    BotKind bot;
+    SimParams params;
+    uint64_t seed;
+    double hz;
+    double max_seconds;
+    int serve_delay;
+    int thread_count;
+    JobQueue* queues;
+    const Level* level;
+} BatchConfig;
+
+typedef struct {
+    const BatchConfig* config;
+    int index;
+    long long stolen;
+    BatchStats stats;
+} Worker;
+
+static bool queue_pop(JobQueue* q, int* job) {
+    pthread_mutex_lock(&q->lock);
+    bool ok = q->tail > q->head;
+    if (ok) *job = q->jobs[--q->tail];
+    pthread_mutex_unlock(&q->lock);
+    return ok;
+}
+
+static bool queue_steal(JobQueue* q, int* job) {
+    pthread_mutex_lock(&q->lock);
+    bool ok = q->tail > q->head;
+    if (ok) *job = q->jobs[q->head++];
+    pthread_mutex_unlock(&q->lock);
+    return ok;
+}
+
+// jobs are never added once the workers start, so a full sweep of empty queues means we are done
+static bool next_job(Worker* wk, int* job) {
+    const BatchConfig* c = wk->config;
+    if (queue_pop(&c->queues[wk->index], job)) return true;
+    for (int i = 1; i < c->thread_count; i++) {
+        if (queue_steal(&c->queues[(wk->index + i) % c->thread_count], job)) {
+            wk->stolen += 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void run_game(Worker* wk, SimWorld* world, int game) {
+    const BatchConfig* c = wk->config;
+    double dt = 1.0 / c->hz;
+    long long max_ticks = (long long)(c->max_seconds * c->hz);
+
+    sim_init_params(world, &c->params);
+    sim_seed(world, c->seed + (uint64_t)game);
+    if (c->level) sim_load_level(world, c->level);
+    Bot bot;
+    bot_init(&bot, c->bot, c->seed ^ ((uint64_t)game * 0x9E3779B97F4A7C15ull), c->serve_delay);
+
+    int lives_lost = 0;
+    long long play_ticks = 0;
+    bool finished = false;
+    long long t = 0;
+    for (; t < max_ticks; t++) {
+        SimInput in = bot_input(&bot, world);
+        if (world->status != IN_MENU) play_ticks += 1;
+        uint32_t events = sim_step(world, &in, dt);
+        if (events & SIM_EVENT_LIFE_LOST) lives_lost += 1;
+        if (events & SIM_EVENT_GAME_OVER) {
+            finished = true;
+            t += 1;
+            break;
+        }
+    }
+
+    BatchStats* s = &wk->stats;
+    int score = finished ? world->last_score : world->points;
+    double seconds = play_ticks * dt;
+    s->games += 1;
+    s->ticks += t;
+    s->total_score += score;
+    s->total_seconds += seconds;
+    if (s->games == 1 || score < s->min_score) s->min_score = score;
+    if (score > s->max_score) s->max_score = score;
+    if (!finished) s->unfinished += 1;
+    else if (lives_lost < MAX_LIVES) s->cleared += 1;
+
+    int sb = score / SCORE_BIN;
+    s->score_hist[sb < SCORE_BINS ? sb : SCORE_BINS - 1] += 1;
+    int db = (int)(seconds / DURATION_BIN);
+    s->duration_hist[db < DURATION_BINS ? db : DURATION_BINS - 1] += 1;
+    s->lives_hist[lives_lost <= MAX_LIVES ? lives_lost : MAX_LIVES] += 1;
+}
+
+static void* worker_main(void* arg) {
+    Worker* wk = arg;
+    SimWorld* world = malloc(sizeof(SimWorld));
+    if (world == NULL) return NULL;
+
+    int job;
+    while (next_job(wk, &job)) {
+        run_game(wk, world, job);
+    }
+    free(world);
+    return NULL;
+}
+
+static void merge_stats(BatchStats* into, const BatchStats* s) {
+    if (s->games == 0) return;
+    if (into->games == 0 || s->min_score < into->min_score) into->min_score = s->min_score;
+    if (s->max_score > into->max_score) into->max_score = s->max_score;
+    into->games += s->games;
+    into->cleared += s->cleared;
+    into->unfinished += s->unfinished;
+    into->ticks += s->ticks;
+    into->total_score += s->total_score;
+    into->total_seconds += s->total_seconds;
+    for (int i = 0; i < SCORE_BINS; i++) into->score_hist[i] += s->score_hist[i];
+    for (int i = 0; i < DURATION_BINS; i++) into->duration_hist[i] += s->duration_hist[i];
+    for (int i = 0; i <= MAX_LIVES; i++) into->lives_hist[i] += s->lives_hist[i];
+}
+
+static void print_histogram(const char* title, const long long* bins, int count, int width, const char* unit) {
+    long long peak = 0;
+    int first = count, last = -1;
+    for (int i = 0; i < count; i++) {
+        if (bins[i] > peak) peak = bins[i];
+        if (bins[i] > 0 && i < first) first = i;
+        if (bins[i] > 0) last = i;
+    }
+    printf("\n%s\n", title);
+    for (int i = first; i <= last; i++) {
+        int bar = peak ? (int)((bins[i] * HIST_BAR_WIDTH + peak - 1) / peak) : 0;
+        if (width == 1) printf("  %6d%-4s", i, unit);
+        else if (i == count - 1) printf("  %6d+%-3s", i * width, unit);
+        else printf("  %6d%-4s", i * width, unit);
+        printf(" %8lld |%.*s\n", bins[i], bar, "##################################################");
+    }
+}
+
+static int cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+static double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + (ts.tv_nsec * 1e-9);
+}
+
+static void usage(const char* name) {
+    printf("usage: %s [--games n] [--threads n] [--bot tracker|predict|sloppy] [--seed n]\n"
+           "       [--tick-rate hz] [--max-seconds s] [--serve-delay ticks]\n"
+           "       [--red n] [--pink n] [--green n] [--yellow n] [--boost a,b] [--boost-speed f] [--angle f]\n"
+           "       [--multiball-chance f]\n"
+           "       [--level pack] [--level-index n]   (level files carry their own brick points)\n", name);
+}
+
+int main(int argc, char* argv[]) {
+    int games = 10000;
+    const char* level_path = NULL;
+    int level_index = 0;
+    BatchConfig config = {
+        .bot = BOT_PREDICT,
+        .params = sim_default_params,
+        .seed = 1,
+        .hz = 60.0,
+        .max_seconds = 3600.0,
+        .serve_delay = 30,
+        .thread_count = cpu_count(),
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (val == NULL) {
+            usage(argv[0]);
+            return -1;
+        }
+        i++;
+        if (strcmp(arg, "--games") == 0) games = atoi(val);
+        else if (strcmp(arg, "--threads") == 0) config.thread_count = atoi(val);
+        else if (strcmp(arg, "--seed") == 0) config.seed = strtoull(val, NULL, 10);
+        else if (strcmp(arg, "--tick-rate") == 0) config.hz = atof(val);
+        else if (strcmp(arg, "--max-seconds") == 0) config.max_seconds = atof(val);
+        else if (strcmp(arg, "--serve-delay") == 0) config.serve_delay = atoi(val);
+        else if (strcmp(arg, "--red") == 0) config.params.red_points = atoi(val);
+        else if (strcmp(arg, "--pink") == 0) config.params.pink_points = atoi(val);
+        else if (strcmp(arg, "--green") == 0) config.params.green_points = atoi(val);
+        else if (strcmp(arg, "--yellow") == 0) config.params.yellow_points = atoi(val);
+        else if (strcmp(arg, "--boost-speed") == 0) config.params.boost_speed = (float)atof(val);
+        else if (strcmp(arg, "--angle") == 0) config.params.collision_angle = (float)atof(val);
+        else if (strcmp(arg, "--multiball-chance") == 0) config.params.multiball_chance = (float)atof(val);
+        else if (strcmp(arg, "--level") == 0) level_path = val;
+        else if (strcmp(arg, "--level-index") == 0) level_index = atoi(val);
+        else if (strcmp(arg, "--boost") == 0) {
+            if (sscanf(val, "%d,%d", &config.params.boost_hits[0], &config.params.boost_hits[1]) != 2) {
+                usage(argv[0]);
+                return -1;
+            }
+        } else if (strcmp(arg, "--bot") == 0) {
+            if (!bot_parse_kind(val, &config.bot)) {
+                printf("Error_bot: unknown kind %s\n", val);
+                return -1;
+            }
+        } else {
+            usage(argv[0]);
+            return -1;
+        }
+    }
+    if (games <= 0 || config.hz <= 0.0 || config.max_seconds <= 0.0 || config.serve_delay < 0) {
+        usage(argv[0]);
+        return -1;
+    }
+    // the pack stays mapped for the whole run, every worker copies its cells from the same view
+    LevelPack pack = {0};
+    Level level;
+    if (level_path) {
+        if (!level_pack_open(&pack, level_path) || !level_pack_get(&pack, level_index, &level)) return -1;
+        config.level = &level;
+    }
+    if (config.thread_count < 1) config.thread_count = 1;
+    if (config.thread_count > BATCH_MAX_THREADS) config.thread_count = BATCH_MAX_THREADS;
+    if (config.thread_count > games) config.thread_count = games;
+
+    // hand every worker a contiguous slice up front; stealing evens out games of very different lengths
+    int* jobs = malloc(sizeof(int) * games);
+    JobQueue* queues = calloc(config.thread_count, sizeof(JobQueue));
+    Worker* workers = calloc(config.thread_count, sizeof(Worker));
+    pthread_t* threads = calloc(config.thread_count, sizeof(pthread_t));
+    if (!jobs || !queues || !workers || !threads) {
+        printf("Error_alloc: out of memory\n");
+        return -1;
+    }
+    for (int i = 0; i < games; i++) jobs[i] = i;
+    for (int i = 0; i < config.thread_count; i++) {
+        pthread_mutex_init(&queues[i].lock, NULL);
+        queues[i].jobs = jobs;
+        queues[i].head = (int)((long long)games * i / config.thread_count);
+        queues[i].tail = (int)((long long)games * (i + 1) / config.thread_count);
+    }
+    config.queues = queues;
+
+    double start = wall_seconds();
+    int started = 0;
+    for (int i = 0; i < config.thread_count; i++) {
+        workers[i].config = &config;
+        workers[i].index = i;
+        if (pthread_create(&threads[i], NULL, worker_main, &workers[i]) != 0) {
+            printf("Error_thread: could not start worker %d\n", i);
+            break;
+        }
+        started += 1;
+    }
+    if (started == 0) return -1;
+
+    BatchStats total = {0};
+    long long stolen = 0;
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+        merge_stats(&total, &workers[i].stats);
+        stolen += workers[i].stolen;
+    }
+    double elapsed = wall_seconds() - start;
+
+    for (int i = 0; i < config.thread_count; i++) pthread_mutex_destroy(&queues[i].lock);
+    free(threads);
+    free(workers);
+    free(queues);
+    free(jobs);
+
+    const SimParams* p = &config.params;
+    printf("bot: %s, seed: %llu, %d threads, %.0f Hz, level: %s\n", bot_kind_name(config.bot),
+           (unsigned long long)config.seed, started, config.hz, config.level ? config.level->header->name : "built-in");
+    printf("params: red %d pink %d green %d yellow %d, boost at %d/%d +%.2f, angle %.2f, multiball %.3f\n",
+           p->red_points, p->pink_points, p->green_points, p->yellow_points,
+           p->boost_hits[0], p->boost_hits[1], p->boost_speed, p->collision_angle, p->multiball_chance);
+    printf("games: %lld (%lld cleared, %lld unfinished), %lld stolen jobs\n", total.games, total.cleared, total.unfinished, stolen);
+    printf("wall: %.3fs, %.1f games/s, %.2f Mticks/s\n", elapsed, elapsed > 0.0 ? total.games / elapsed : 0.0,
+           elapsed > 0.0 ? (total.ticks / elapsed) / 1e6 : 0.0);
+    if (total.games > 0) {
+        printf("score: min %d, max %d, mean %.1f\n", total.min_score, total.max_score, (double)total.total_score / total.games);
+        printf("duration: mean %.1fs\n", total.total_seconds / total.games);
+    }
+
+    print_histogram("score", total.score_hist, SCORE_BINS, SCORE_BIN, "");
+    print_histogram("duration", total.duration_hist, DURATION_BINS, DURATION_BIN, "s");
+    print_histogram("lives lost", total.lives_hist, MAX_LIVES + 1, 1, "");
+    level_pack_close(&pack);
+    return 0;
+}
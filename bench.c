@@ -0,0 +1,394 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include "sim.h"
+#include "bot.h"
+#include "level.h"
+#include "particles.h"
+#ifndef BENCH_NO_DRAW
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+#include "render.h"
+#include "text.h"
+#endif
+
+// Times the per-tick hot paths on fixed scenario fixtures and writes min/median/p99 as JSON.
+// Every fixture is rebuilt from scratch and the world is restored from it every BENCH_WINDOW
+// ticks, with a seeded bot on the paddle, so two runs measure exactly the same work.
+//   update   sim_step()
+//   collide  sim_brick_query() for the first ball's next tick, the brick half of a contact step
+//   scan     brick_sweep() over every cell of the board, the raw kernel
+//   draw     the frame draw_game() builds, on a software renderer (not in the bench-sim build)
+//   particles  particles_update() and particles_build() with BENCH_PARTICLES sparks alive, sampled
+//              every BENCH_PARTICLE_EVERY ticks
+//   particles_draw  particles_flush() of those sparks, the SDL_RenderGeometryRaw() call and the
+//              renderer flush that rasterises it, on the same software renderer as draw
+
+#define BENCH_HZ 60
+#define BENCH_WINDOW 120
+#define BENCH_DEFAULT_TICKS 60000
+#define BENCH_PARTICLES 50000
+#define BENCH_PARTICLE_EVERY 15
+
+typedef enum {
+    METRIC_UPDATE=0,
+    METRIC_COLLIDE,
+    METRIC_SCAN,
+    METRIC_DRAW,
+    METRIC_PARTICLES,
+    METRIC_PARTICLES_DRAW,
+    MAX_METRICS
+} Metric;
+
+static const char* metric_names[MAX_METRICS] = {"update", "collide", "scan", "draw", "particles", "particles_draw"};
+
+typedef struct {
+    const char* name;
+    const char* about;
+    void (*build)(SimWorld* w);
+} Scenario;
+
+typedef struct {
+    double min;
+    double median;
+    double p99;
+    double mean;
+} Summary;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+//::fixtures
+
+// menu -> serve, then parks the ball below the board heading up into it
+static void start_play(SimWorld* w, float x, float y, float vel_x) {
+    SimInput in = {.menu_yes = true};
+    sim_step(w, &in, 1.0 / BENCH_HZ);
+    in = (SimInput) {.serve = true};
+    sim_step(w, &in, 1.0 / BENCH_HZ);
+    Ball* b = &w->balls[0];
+    b->shape.x = x;
+    b->shape.y = y;
+    b->prev = b->shape;
+    b->vel_x = vel_x;
+    b->vel_y = -1.0f;
+}
+
+static void build_full(SimWorld* w) {
+    sim_init(w);
+    sim_seed(w, 1);
+    start_play(w, WIDTH * 0.3f, HEIGHT * 0.55f, 0.6f);
+}
+
+static void build_sparse(SimWorld* w) {
+    build_full(w);
+    BrickField* f = &w->bricks;
+    memset(f->row_alive, 0, sizeof(f->row_alive));
+    f->row_alive[0] = 1ull << (f->cols - 1);
+    w->brick_count = 1;
+}
+
+static void build_fast(SimWorld* w) {
+    build_full(w);
+    // a long rally at top speed: the sim only keeps the boost while consecutive_hits > 0, and past
+    // the second boost threshold no later hit in the window speeds the ball up any further
+    w->consecutive_hits = w->params.boost_hits[1] + 1;
+    w->first_hit_pink_or_red = true;
+    w->balls[0].speed_modifier = 0.9f + 2.0f * w->params.boost_speed;
+    w->balls[0].move_speed = MIN_BALL_SPEED + 50;
+}
+
+static void build_big(SimWorld* w) {
+    static LevelHeader header;
+    static SimColor palette[LEVEL_MAX_COLOURS];
+    static uint8_t type[MAX_BRICKS], hp[MAX_BRICKS], colour[MAX_BRICKS], points[MAX_BRICKS];
+    header = (LevelHeader) {.name = "bench-big", .cols = BRICK_MAX_COLS, .rows = BRICK_MAX_ROWS, .colour_count = 4,
+                            .cell_count = MAX_BRICKS, .hash = 0x62656e6368ull};
+    palette[0] = (SimColor) {154, 78, 78, 255};
+    palette[1] = (SimColor) {179, 100, 138, 255};
+    palette[2] = (SimColor) {99, 141, 91, 255};
+    palette[3] = (SimColor) {187, 165, 59, 255};
+    for (int i = 0; i < MAX_BRICKS; i++) {
+        type[i] = BRICK_NORMAL;
+        hp[i] = 1;
+        colour[i] = (uint8_t)((i / BRICK_MAX_COLS) * 4 / BRICK_MAX_ROWS);
+        points[i] = 1;
+    }
+    Level lv = {.header = &header, .palette = palette, .type = type, .hp = hp, .colour = colour, .points = points};
+
+    sim_init(w);
+    sim_seed(w, 1);
+    sim_load_level(w, &lv);
+    start_play(w, WIDTH * 0.3f, HEIGHT * 0.55f, 0.6f);
+}
+
+static const Scenario scenarios[] = {
+    {"full", "classic board, every brick standing", build_full},
+    {"sparse", "classic board, one brick left", build_sparse},
+    {"fast", "classic board, ball at speed_modifier 1.4", build_fast},
+    {"big", "64 x 32 custom board, 2048 bricks", build_big},
+};
+
+//::draw
+
+#ifndef BENCH_NO_DRAW
+typedef struct {
+    SDL_Surface* surface;
+    SDL_Renderer* renderer;
+    TTF_Font* fonts[MAX_FONT_SIZES];
+    GlyphAtlas atlas;
+    ShapeBatch shapes;
+    bool text;
+} DrawBench;
+
+static bool draw_open(DrawBench* d) {
+    memset(d, 0, sizeof(*d));
+    if (!SDL_Init(0)) {
+        printf("Error_init: %s\n", SDL_GetError());
+        return false;
+    }
+    d->surface = SDL_CreateSurface(WIDTH, HEIGHT, SDL_PIXELFORMAT_XRGB8888);
+    d->renderer = d->surface ? SDL_CreateSoftwareRenderer(d->surface) : NULL;
+    if (d->renderer == NULL) {
+        printf("Error_renderer: %s\n", SDL_GetError());
+        return false;
+    }
+    // the frame is still timed without the hotbar text if the font can't be found
+    d->text = TTF_Init() && fonts_open(d->fonts, "fonts/FiraCode-Bold.ttf")
+              && glyph_atlas_create(&d->atlas, d->renderer, d->fonts);
+    shape_batch_init(&d->shapes);
+    return true;
+}
+
+static void draw_close(DrawBench* d) {
+    if (d->text) glyph_atlas_destroy(&d->atlas);
+    fonts_close(d->fonts);
+    if (d->renderer) SDL_DestroyRenderer(d->renderer);
+    if (d->surface) SDL_DestroySurface(d->surface);
+    SDL_Quit();
+}
+
+// the same work draw_game() in main.c does for a frame in play, minus the menu overlay
+static void draw_frame(DrawBench* d, const SimWorld* w) {
+    SDL_Color white = {220, 220, 220, 255};
+    SDL_Color off_black = {33, 33, 33, 255};
+    SDL_SetRenderDrawBlendMode(d->renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(d->renderer, off_black.r, off_black.g, off_black.b, off_black.a);
+    SDL_RenderClear(d->renderer);
+
+    if (d->text) {
+        char text[32];
+        snprintf(text, sizeof(text), "Lives: %d", w->lives);
+        text_queue(&d->atlas, FONT_SMALL, text, 0, 0, white);
+        snprintf(text, sizeof(text), "Points: %d", w->points);
+        text_queue(&d->atlas, FONT_SMALL, text, 0.2f * WIDTH, 0, white);
+        snprintf(text, sizeof(text), "%02d:%02d", w->time.minutes, w->time.seconds);
+        text_queue(&d->atlas, FONT_SMALL, text, 0.5f * WIDTH, 0, white);
+    }
+
+    shape_batch_update_bricks(&d->shapes, w);
+    shape_batch_add(&d->shapes, (SDL_FRect) {0, 0, WIDTH, HOTBAR_H}, off_black);
+    for (int i = 0; i < w->ball_count; i++) {
+        SimRect r = w->balls[i].shape;
+        shape_batch_add(&d->shapes, (SDL_FRect) {r.x, r.y, r.w, r.h}, white);
+    }
+    SimRect p = w->player.shape;
+    shape_batch_add(&d->shapes, (SDL_FRect) {p.x, p.y, p.w, p.h}, white);
+    shape_batch_flush(&d->shapes, d->renderer);
+    if (d->text) text_flush(&d->atlas, d->renderer);
+    SDL_FlushRenderer(d->renderer);
+}
+#endif
+
+//::measure
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static Summary summarize(double* samples, long n) {
+    Summary s = {0};
+    if (n == 0) return s;
+    qsort(samples, (size_t)n, sizeof(double), compare_double);
+    double total = 0.0;
+    for (long i = 0; i < n; i++) total += samples[i];
+    s.min = samples[0];
+    s.median = samples[n / 2];
+    s.p99 = samples[(long)((double)(n - 1) * 0.99)];
+    s.mean = total / (double)n;
+    return s;
+}
+
+// runs one scenario; samples[m] gets one time per tick for every metric m that was measured
+static void run_scenario(const Scenario* sc, long ticks, double* samples[MAX_METRICS], long counts[MAX_METRICS], void* draw) {
+    static SimWorld fixture, world;
+    static float toi[BRICK_CAPACITY];
+    static uint8_t axis[BRICK_CAPACITY];
+    static ParticleSystem particles;
+    sc->build(&fixture);
+    particles_init(&particles, 1);
+
+    const double dt = 1.0 / BENCH_HZ;
+    Bot bot;
+    volatile int sink = 0;
+    for (int m = 0; m < MAX_METRICS; m++) counts[m] = 0;
+
+    for (long t = 0; t < ticks; t++) {
+        if (t % BENCH_WINDOW == 0) {
+            world = fixture;
+            bot_init(&bot, BOT_TRACKER, 1, 0);
+        }
+        SimInput in = bot_input(&bot, &world);
+
+        const Ball* b = &world.balls[0];
+        // one tick of the ball's motion, as ball_velocity() in sim.c works it out
+        float slant = 1.0f - fabsf(b->vel_x);
+        float vx = b->vel_x * b->speed_modifier * (b->move_speed + slant * b->move_speed) * (float)dt;
+        float vy = b->vel_y * b->speed_modifier * (b->move_speed * (1.0f + slant)) * (float)dt;
+
+        double start = now_ns();
+        float hit_toi;
+        SimAxis hit_axis;
+        sink += sim_brick_query(&world, &b->shape, vx, vy, &hit_toi, &hit_axis);
+        double mid = now_ns();
+        brick_sweep(&world.bricks, 0, world.bricks.cols * world.bricks.rows, &b->shape, vx, vy, toi, axis);
+        double end = now_ns();
+        sink += axis[0];
+        samples[METRIC_COLLIDE][counts[METRIC_COLLIDE]++] = mid - start;
+        samples[METRIC_SCAN][counts[METRIC_SCAN]++] = end - mid;
+
+        start = now_ns();
+        sim_step(&world, &in, dt);
+        samples[METRIC_UPDATE][counts[METRIC_UPDATE]++] = now_ns() - start;
+
+        if (t % BENCH_PARTICLE_EVERY == 0) {
+            while (particles.count < BENCH_PARTICLES) {
+                particles_burst(&particles, world.balls[0].shape, world.player.colour, 256, 220.0f, 0.8f);
+            }
+            start = now_ns();
+            particles_update(&particles, (float)dt);
+            particles_build(&particles);
+            samples[METRIC_PARTICLES][counts[METRIC_PARTICLES]++] = now_ns() - start;
+#ifndef BENCH_NO_DRAW
+            if (draw) {
+                DrawBench* d = draw;
+                start = now_ns();
+                particles_flush(&particles, d->renderer);
+                SDL_FlushRenderer(d->renderer);
+                samples[METRIC_PARTICLES_DRAW][counts[METRIC_PARTICLES_DRAW]++] = now_ns() - start;
+            }
+#endif
+        }
+
+#ifndef BENCH_NO_DRAW
+        if (draw) {
+            start = now_ns();
+            draw_frame(draw, &world);
+            samples[METRIC_DRAW][counts[METRIC_DRAW]++] = now_ns() - start;
+        }
+#else
+        (void)draw;
+#endif
+    }
+    (void)sink;
+}
+
+static const char* kernel_name(void) {
+#if !defined(SIM_SCALAR) && defined(__AVX__)
+    return "avx";
+#elif !defined(SIM_SCALAR) && (defined(__SSE2__) || defined(_M_X64))
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+int main(int argc, char* argv[]) {
+    long ticks = BENCH_DEFAULT_TICKS;
+    const char* out_path = "bench.json";
+    const char* only = NULL;
+    bool draw_enabled = true;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            ticks = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else if (strcmp(argv[i], "--no-draw") == 0) {
+            draw_enabled = false;
+        } else {
+            ticks = 0;
+            break;
+        }
+    }
+    if (ticks <= 0) {
+        printf("usage: %s [--ticks n] [--scenario full|sparse|fast|big] [--no-draw] [--out file.json]\n", argv[0]);
+        return -1;
+    }
+
+    void* draw = NULL;
+#ifndef BENCH_NO_DRAW
+    static DrawBench draw_bench;
+    if (draw_enabled) {
+        if (!draw_open(&draw_bench)) return -1;
+        draw = &draw_bench;
+    }
+#else
+    draw_enabled = false;
+#endif
+
+    double* samples[MAX_METRICS];
+    for (int m = 0; m < MAX_METRICS; m++) {
+        samples[m] = malloc(sizeof(double) * (size_t)ticks);
+        if (samples[m] == NULL) {
+            printf("Error_bench: out of memory for %ld ticks\n", ticks);
+            return -1;
+        }
+    }
+
+    FILE* out = fopen(out_path, "w");
+    if (!out) {
+        printf("Error_bench: could not create %s\n", out_path);
+        return -1;
+    }
+    fprintf(out, "{\n  \"ticks\": %ld,\n  \"tick_rate\": %d,\n  \"kernel\": \"%s\",\n  \"draw\": %s,\n  \"scenarios\": [",
+            ticks, BENCH_HZ, kernel_name(), draw_enabled ? "true" : "false");
+
+    printf("%-8s %-14s %10s %10s %10s   (ns per tick)\n", "scenario", "metric", "min", "median", "p99");
+    int written = 0;
+    for (int s = 0; s < (int)(sizeof(scenarios) / sizeof(scenarios[0])); s++) {
+        const Scenario* sc = &scenarios[s];
+        if (only && strcmp(only, sc->name) != 0) continue;
+        long counts[MAX_METRICS];
+        run_scenario(sc, ticks, samples, counts, draw);
+
+        fprintf(out, "%s\n    {\n      \"name\": \"%s\",\n      \"about\": \"%s\"", written++ ? "," : "", sc->name, sc->about);
+        for (int m = 0; m < MAX_METRICS; m++) {
+            if (counts[m] == 0) continue;
+            Summary sum = summarize(samples[m], counts[m]);
+            fprintf(out, ",\n      \"%s\": {\"samples\": %ld, \"min_ns\": %.0f, \"median_ns\": %.0f, \"p99_ns\": %.0f, \"mean_ns\": %.1f}",
+                    metric_names[m], counts[m], sum.min, sum.median, sum.p99, sum.mean);
+            printf("%-8s %-14s %10.0f %10.0f %10.0f\n", sc->name, metric_names[m], sum.min, sum.median, sum.p99);
+        }
+        fprintf(out, "\n    }");
+    }
+    fprintf(out, "\n  ]\n}\n");
+    bool ok = !ferror(out);
+    if (fclose(out) != 0) ok = false;
+    if (!ok) printf("Error_bench: could not write %s\n", out_path);
+    else printf("wrote %s\n", out_path);
+
+    for (int m = 0; m < MAX_METRICS; m++) free(samples[m]);
+#ifndef BENCH_NO_DRAW
+    if (draw) draw_close(draw);
+#endif
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+#include "bot.h"
+#include <math.h>
+#include <string.h>
+
+static const char* bot_names[BOT_COUNT] = {"tracker", "predict", "sloppy"};
+
+// xorshift64*, good enough for jittering a paddle
+static uint32_t bot_rand(Bot* b) {
+    b->rng ^= b->rng >> 12;
+    b->rng ^= b->rng << 25;
+    b->rng ^= b->rng >> 27;
+    return (uint32_t)((b->rng * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+static float bot_randf(Bot* b, float lo, float hi) {
+    return lo + (hi - lo) * ((float)bot_rand(b) / 4294967296.0f);
+}
+
+void bot_init(Bot* b, BotKind kind, uint64_t seed, int max_serve_delay) {
+    memset(b, 0, sizeof(*b));
+    b->kind = kind;
+    // splitmix64 the seed so neighbouring seeds give unrelated streams
+    uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    b->rng = (z ^ (z >> 31)) | 1u;
+    b->max_serve_delay = max_serve_delay;
+    b->serve_wait = -1;
+}
+
+// with several balls in play, chase the lowest one that is coming down (or just the lowest)
+static const Ball* lead_ball(const SimWorld* w) {
+    const Ball* lead = &w->balls[0];
+    for (int i = 1; i < w->ball_count; i++) {
+        const Ball* b = &w->balls[i];
+        bool b_falling = b->shape.y > b->prev.y;
+        bool lead_falling = lead->shape.y > lead->prev.y;
+        if ((b_falling && !lead_falling) || (b_falling == lead_falling && b->shape.y > lead->shape.y)) lead = b;
+    }
+    return lead;
+}
+
+// x the ball's centre will have when it reaches the paddle, folding the path off the side walls
+static float predict_landing(const SimWorld* w, const Ball* ball, float dx, float dy) {
+    float cx = ball->shape.x + (0.5f * ball->shape.w);
+    if (dy <= 0.0f) return cx;
+
+    float ticks = (w->player.shape.y - (ball->shape.y + ball->shape.h)) / dy;
+    float lo = 0.5f * ball->shape.w;
+    float span = WIDTH - ball->shape.w;
+    float x = fmodf(cx + (dx * ticks) - lo, 2.0f * span);
+    if (x < 0.0f) x += 2.0f * span;
+    if (x > span) x = (2.0f * span) - x;
+    return x + lo;
+}
+
+SimInput bot_input(Bot* b, const SimWorld* w) {
+    SimInput in = {0};
+
+    if (w->status == IN_MENU) {
+        in.menu_yes = true;
+        return in;
+    }
+    if (w->status == RESET_ROUND) {
+        if (b->serve_wait < 0) {
+            b->serve_wait = b->max_serve_delay > 0 ? (int)(bot_rand(b) % (uint32_t)(b->max_serve_delay + 1)) : 0;
+        }
+        if (b->serve_wait-- == 0) {
+            in.serve = true;
+            b->serve_wait = -1;
+        }
+    }
+
+    const Ball* ball = lead_ball(w);
+    float mid_ball = ball->shape.x + (0.5f * ball->shape.w);
+    float mid_paddle = w->player.shape.x + (0.5f * w->player.shape.w);
+    float dead_zone = 0.25f * w->player.shape.w;
+    float target = mid_ball;
+
+    float dx = ball->shape.x - ball->prev.x;
+    float dy = ball->shape.y - ball->prev.y;
+
+    switch (b->kind) {
+        case BOT_TRACKER:
+            break;
+        case BOT_PREDICT:
+            // pick a new aim point on the paddle every time the ball heads back up
+            if (dy < 0.0f) b->aim = bot_randf(b, -0.35f, 0.35f) * w->player.shape.w;
+            target = predict_landing(w, ball, dx, dy) + b->aim;
+            dead_zone = 0.1f * w->player.shape.w;
+            break;
+        case BOT_SLOPPY:
+            if (b->react_wait-- <= 0) {
+                b->react_wait = 4 + (int)(bot_rand(b) % 12);
+                b->target = mid_ball + bot_randf(b, -0.4f, 0.4f) * w->player.shape.w;
+            }
+            target = b->target;
+            break;
+        default:
+            break;
+    }
+
+    if (target < mid_paddle - dead_zone) in.move_left = true;
+    else if (target > mid_paddle + dead_zone) in.move_right = true;
+
+    return in;
+}
+
+bool bot_parse_kind(const char* name, BotKind* kind) {
+    for (int i = 0; i < BOT_COUNT; i++) {
+        if (strcmp(name, bot_names[i]) == 0) {
+            *kind = (BotKind)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* bot_kind_name(BotKind kind) {
+    return (kind >= 0 && kind < BOT_COUNT) ? bot_names[kind] : "unknown";
+}
@@ -0,0 +1,29 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "sim.h"
+
+typedef enum {
+    BOT_TRACKER,    // keeps the paddle under the ball, no randomness
+    BOT_PREDICT,    // projects the ball's landing point off the walls and aims with a random offset
+    BOT_SLOPPY,     // tracks the ball with a random reaction delay and error
+    BOT_COUNT,
+} BotKind;
+
+// scripted paddle player; all state lives here so any number can run side by side
+typedef struct {
+    BotKind kind;
+    uint64_t rng;
+    int max_serve_delay;
+    int serve_wait;
+    float aim;
+    float target;
+    int react_wait;
+} Bot;
+
+void bot_init(Bot* b, BotKind kind, uint64_t seed, int max_serve_delay);
+SimInput bot_input(Bot* b, const SimWorld* w);
+bool bot_parse_kind(const char* name, BotKind* kind);
+const char* bot_kind_name(BotKind kind);
+
+#endif
@@ -0,0 +1,160 @@
+#include "sim.h"
+#include <math.h>
+
+#if !defined(SIM_SCALAR) && defined(__AVX__)
+#include <immintrin.h>
+#define BRICK_AVX
+#elif !defined(SIM_SCALAR) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define BRICK_SSE2
+#endif
+
+// swept AABB: fraction of (dx, dy) at which moving box a first touches static box b, and the axis it hits on
+bool sim_sweep_rect(const SimRect* a, float dx, float dy, const SimRect* b, float* toi, SimAxis* axis) {
+    if (sim_rect_overlap(a, b)) {
+        *toi = 0.0f;
+        *axis = AXIS_Y;
+        return true;
+    }
+
+    float x_entry = -INFINITY, x_exit = INFINITY;
+    if (dx > 0.0f) {
+        x_entry = (b->x - (a->x + a->w)) / dx;
+        x_exit = (b->x + b->w - a->x) / dx;
+    } else if (dx < 0.0f) {
+        x_entry = (b->x + b->w - a->x) / dx;
+        x_exit = (b->x - (a->x + a->w)) / dx;
+    } else if (a->x >= b->x + b->w || a->x + a->w <= b->x) {
+        return false;
+    }
+
+    float y_entry = -INFINITY, y_exit = INFINITY;
+    if (dy > 0.0f) {
+        y_entry = (b->y - (a->y + a->h)) / dy;
+        y_exit = (b->y + b->h - a->y) / dy;
+    } else if (dy < 0.0f) {
+        y_entry = (b->y + b->h - a->y) / dy;
+        y_exit = (b->y - (a->y + a->h)) / dy;
+    } else if (a->y >= b->y + b->h || a->y + a->h <= b->y) {
+        return false;
+    }
+
+    float entry = fmaxf(x_entry, y_entry);
+    float exit = fminf(x_exit, y_exit);
+    if (entry >= exit || entry < 0.0f || entry > 1.0f) return false;
+
+    *toi = entry;
+    *axis = (x_entry > y_entry) ? AXIS_X : AXIS_Y;
+    return true;
+}
+
+// The vector paths below do the same arithmetic in the same order as sim_sweep_rect, one brick per
+// lane, so every build (AVX, SSE2 or -DSIM_SCALAR) produces bit-identical times of impact and replays
+// stay portable. The sign of dx/dy is the same for every lane, so those branches stay scalar.
+
+#if defined(BRICK_AVX)
+#define BRICK_WIDTH 8
+#define VF __m256
+#define v_load _mm256_loadu_ps
+#define v_store _mm256_storeu_ps
+#define v_set1 _mm256_set1_ps
+#define v_add _mm256_add_ps
+#define v_sub _mm256_sub_ps
+#define v_div _mm256_div_ps
+#define v_max _mm256_max_ps
+#define v_min _mm256_min_ps
+#define v_and _mm256_and_ps
+#define v_or _mm256_or_ps
+#define v_andnot _mm256_andnot_ps
+#define v_blend(a, b, m) _mm256_blendv_ps(a, b, m)
+#define v_lt(a, b) _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+#define v_gt(a, b) _mm256_cmp_ps(a, b, _CMP_GT_OQ)
+#define v_ge(a, b) _mm256_cmp_ps(a, b, _CMP_GE_OQ)
+#define v_le(a, b) _mm256_cmp_ps(a, b, _CMP_LE_OQ)
+#define v_mask _mm256_movemask_ps
+#elif defined(BRICK_SSE2)
+#define BRICK_WIDTH 4
+#define VF __m128
+#define v_load _mm_loadu_ps
+#define v_store _mm_storeu_ps
+#define v_set1 _mm_set1_ps
+#define v_add _mm_add_ps
+#define v_sub _mm_sub_ps
+#define v_div _mm_div_ps
+#define v_max _mm_max_ps
+#define v_min _mm_min_ps
+#define v_and _mm_and_ps
+#define v_or _mm_or_ps
+#define v_andnot _mm_andnot_ps
+#define v_blend(a, b, m) _mm_or_ps(_mm_andnot_ps(m, a), _mm_and_ps(m, b))
+#define v_lt _mm_cmplt_ps
+#define v_gt _mm_cmpgt_ps
+#define v_ge _mm_cmpge_ps
+#define v_le _mm_cmple_ps
+#define v_mask _mm_movemask_ps
+#endif
+
+void brick_sweep(const BrickField* f, int first, int count, const SimRect* a, float dx, float dy, float* toi, uint8_t* axis) {
+    int i = 0;
+
+#ifdef BRICK_WIDTH
+    const VF ax = v_set1(a->x), ay = v_set1(a->y);
+    const VF ax_end = v_set1(a->x + a->w), ay_end = v_set1(a->y + a->h);
+    const VF vdx = v_set1(dx), vdy = v_set1(dy);
+    const VF zero = v_set1(0.0f), one = v_set1(1.0f);
+    const VF neg_inf = v_set1(-INFINITY), pos_inf = v_set1(INFINITY);
+
+    for (; i + BRICK_WIDTH <= count; i += BRICK_WIDTH) {
+        VF bx = v_load(&f->x[first + i]);
+        VF by = v_load(&f->y[first + i]);
+        VF bx_end = v_add(bx, v_load(&f->w[first + i]));
+        VF by_end = v_add(by, v_load(&f->h[first + i]));
+
+        VF overlap = v_and(v_and(v_lt(ax, bx_end), v_gt(ax_end, bx)), v_and(v_lt(ay, by_end), v_gt(ay_end, by)));
+        VF miss = zero;
+
+        VF x_entry = neg_inf, x_exit = pos_inf;
+        if (dx > 0.0f) {
+            x_entry = v_div(v_sub(bx, ax_end), vdx);
+            x_exit = v_div(v_sub(bx_end, ax), vdx);
+        } else if (dx < 0.0f) {
+            x_entry = v_div(v_sub(bx_end, ax), vdx);
+            x_exit = v_div(v_sub(bx, ax_end), vdx);
+        } else {
+            miss = v_or(v_ge(ax, bx_end), v_le(ax_end, bx));
+        }
+
+        VF y_entry = neg_inf, y_exit = pos_inf;
+        if (dy > 0.0f) {
+            y_entry = v_div(v_sub(by, ay_end), vdy);
+            y_exit = v_div(v_sub(by_end, ay), vdy);
+        } else if (dy < 0.0f) {
+            y_entry = v_div(v_sub(by_end, ay), vdy);
+            y_exit = v_div(v_sub(by, ay_end), vdy);
+        } else {
+            miss = v_or(miss, v_or(v_ge(ay, by_end), v_le(ay_end, by)));
+        }
+
+        VF entry = v_max(x_entry, y_entry);
+        VF exit = v_min(x_exit, y_exit);
+        miss = v_or(miss, v_or(v_ge(entry, exit), v_or(v_lt(entry, zero), v_gt(entry, one))));
+
+        VF t = v_blend(entry, pos_inf, miss);
+        v_store(&toi[i], v_blend(t, zero, overlap));
+        int hit_x = v_mask(v_andnot(v_or(overlap, miss), v_gt(x_entry, y_entry)));
+        for (int l = 0; l < BRICK_WIDTH; l++) {
+            axis[i + l] = ((hit_x >> l) & 1) ? AXIS_X : AXIS_Y;
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        SimRect b = {f->x[first + i], f->y[first + i], f->w[first + i], f->h[first + i]};
+        SimAxis hit_axis;
+        if (!sim_sweep_rect(a, dx, dy, &b, &toi[i], &hit_axis)) {
+            toi[i] = INFINITY;
+            hit_axis = AXIS_Y;
+        }
+        axis[i] = (uint8_t)hit_axis;
+    }
+}
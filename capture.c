@@ -0,0 +1,216 @@
+#define _POSIX_C_SOURCE 200809L
+#include "capture.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#define PIPE_MODE "wb"
+#else
+#define PIPE_MODE "w"
+#endif
+
+// BT.601 full range, the "420jpeg" Y4M default
+static void rgba_to_yuv420(const uint8_t* rgba, int w, int h, uint8_t* yuv) {
+    int cw = (w + 1) / 2, ch = (h + 1) / 2;
+    uint8_t* y_plane = yuv;
+    uint8_t* u_plane = yuv + w * h;
+    uint8_t* v_plane = u_plane + cw * ch;
+
+    for (int y = 0; y < h; y++) {
+        const uint8_t* p = rgba + (size_t)y * w * 4;
+        for (int x = 0; x < w; x++, p += 4) {
+            y_plane[y * w + x] = (uint8_t)((77 * p[0] + 150 * p[1] + 29 * p[2]) >> 8);
+        }
+    }
+    for (int cy = 0; cy < ch; cy++) {
+        for (int cx = 0; cx < cw; cx++) {
+            int r = 0, g = 0, b = 0, n = 0;
+            for (int dy = 0; dy < 2 && cy * 2 + dy < h; dy++) {
+                for (int dx = 0; dx < 2 && cx * 2 + dx < w; dx++) {
+                    const uint8_t* p = rgba + ((size_t)(cy * 2 + dy) * w + (cx * 2 + dx)) * 4;
+                    r += p[0];
+                    g += p[1];
+                    b += p[2];
+                    n += 1;
+                }
+            }
+            r /= n;
+            g /= n;
+            b /= n;
+            u_plane[cy * cw + cx] = (uint8_t)(((-43 * r - 85 * g + 128 * b) >> 8) + 128);
+            v_plane[cy * cw + cx] = (uint8_t)(((128 * r - 107 * g - 21 * b) >> 8) + 128);
+        }
+    }
+}
+
+static bool write_frame(Capture* c, const uint8_t* rgba) {
+    if (c->format == CAPTURE_RAW) {
+        size_t size = (size_t)c->w * c->h * 4;
+        return fwrite(rgba, 1, size, c->fp) == size;
+    }
+    size_t size = (size_t)c->w * c->h + 2 * (size_t)((c->w + 1) / 2) * ((c->h + 1) / 2);
+    rgba_to_yuv420(rgba, c->w, c->h, c->yuv);
+    return fputs("FRAME\n", c->fp) >= 0 && fwrite(c->yuv, 1, size, c->fp) == size;
+}
+
+// drains the slots in the order they were filled until told to quit with nothing left
+static int capture_thread(void* data) {
+    Capture* c = data;
+    int drain = 0;
+    SDL_LockMutex(c->lock);
+    for (;;) {
+        while (!c->slots[drain].full && !c->quit) SDL_WaitCondition(c->changed, c->lock);
+        if (!c->slots[drain].full) break;
+        SDL_UnlockMutex(c->lock);
+        bool ok = write_frame(c, c->slots[drain].rgba);
+        SDL_LockMutex(c->lock);
+        if (!ok && !c->failed) {
+            printf("Error_capture: could not write a frame, is the disk full or the encoder gone?\n");
+            c->failed = true;
+        }
+        c->slots[drain].full = false;
+        SDL_BroadcastCondition(c->changed);
+        drain = (drain + 1) % CAPTURE_SLOTS;
+    }
+    SDL_UnlockMutex(c->lock);
+    return 0;
+}
+
+bool capture_open(Capture* c, SDL_Renderer* renderer, const char* dest, int w, int h, int fps) {
+    memset(c, 0, sizeof(*c));
+    c->w = w;
+    c->h = h;
+
+    if (dest[0] == '|') {
+        c->pipe = true;
+        c->format = CAPTURE_Y4M;
+        c->fp = popen(dest + 1, PIPE_MODE);
+    } else {
+        const char* dot = strrchr(dest, '.');
+        c->format = (dot && strcmp(dot, ".y4m") == 0) ? CAPTURE_Y4M : CAPTURE_RAW;
+        c->fp = fopen(dest, "wb");
+    }
+    if (c->fp == NULL) {
+        printf("Error_capture: could not open %s\n", dest);
+        return false;
+    }
+    if (c->format == CAPTURE_Y4M) {
+        fprintf(c->fp, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", w, h, fps);
+    }
+
+    c->renderer = renderer;
+    bool ok = true;
+    for (int i = 0; i < CAPTURE_TARGETS; i++) {
+        c->targets[i] = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, w, h);
+        ok = ok && c->targets[i];
+    }
+    // backends may read a target back in their own layout; find out now rather than check every frame
+    if (ok) {
+        SDL_SetRenderTarget(renderer, c->targets[0]);
+        SDL_Surface* probe = SDL_RenderReadPixels(renderer, NULL);
+        SDL_SetRenderTarget(renderer, NULL);
+        ok = probe != NULL;
+        if (ok) c->read_format = probe->format;
+        SDL_DestroySurface(probe);
+    }
+    c->yuv = malloc((size_t)w * h * 2);
+    for (int i = 0; i < CAPTURE_SLOTS; i++) c->slots[i].rgba = malloc((size_t)w * h * 4);
+    c->lock = SDL_CreateMutex();
+    c->changed = SDL_CreateCondition();
+    ok = ok && c->yuv && c->lock && c->changed;
+    for (int i = 0; i < CAPTURE_SLOTS; i++) ok = ok && c->slots[i].rgba;
+    if (ok) c->thread = SDL_CreateThread(capture_thread, "capture", c);
+    if (c->thread == NULL) {
+        printf("Error_capture: %s\n", SDL_GetError());
+        capture_close(c);
+        return false;
+    }
+    return true;
+}
+
+void capture_begin_frame(Capture* c, SDL_Renderer* renderer) {
+    SDL_SetRenderTarget(renderer, c->targets[c->draw]);
+}
+
+// reads a finished target into the next free slot and hands it to the writer
+static bool read_back(Capture* c, SDL_Renderer* renderer, SDL_Texture* target) {
+    SDL_SetRenderTarget(renderer, target);
+    SDL_Surface* shot = SDL_RenderReadPixels(renderer, NULL);
+    SDL_SetRenderTarget(renderer, NULL);
+    if (shot == NULL) {
+        printf("Error_capture_readback: %s\n", SDL_GetError());
+        return false;
+    }
+
+    // wait for the writer to be done with this slot, the other one may still be in flight
+    CaptureSlot* slot = &c->slots[c->fill];
+    SDL_LockMutex(c->lock);
+    while (slot->full) SDL_WaitCondition(c->changed, c->lock);
+    bool failed = c->failed;
+    SDL_UnlockMutex(c->lock);
+
+    int rows = shot->h < c->h ? shot->h : c->h;
+    int cols = shot->w < c->w ? shot->w : c->w;
+    bool ok = shot->format == c->read_format;
+    if (ok && c->read_format == SDL_PIXELFORMAT_RGBA32) {
+        for (int y = 0; y < rows; y++) {
+            memcpy(slot->rgba + (size_t)y * c->w * 4, (const uint8_t*)shot->pixels + (size_t)y * shot->pitch, (size_t)cols * 4);
+        }
+    } else if (ok) {
+        ok = SDL_ConvertPixels(cols, rows, shot->format, shot->pixels, shot->pitch, SDL_PIXELFORMAT_RGBA32, slot->rgba, c->w * 4);
+    }
+    if (!ok) printf("Error_capture_readback: could not convert %s\n", SDL_GetPixelFormatName(shot->format));
+    SDL_DestroySurface(shot);
+    if (!ok) return false;
+
+    SDL_LockMutex(c->lock);
+    slot->full = true;
+    SDL_BroadcastCondition(c->changed);
+    SDL_UnlockMutex(c->lock);
+    c->fill = (c->fill + 1) % CAPTURE_SLOTS;
+    return !failed;
+}
+
+bool capture_end_frame(Capture* c, SDL_Renderer* renderer) {
+    // this frame's commands are queued by now, the previous frame's target has long been drawn
+    bool ok = true;
+    if (c->pending) ok = read_back(c, renderer, c->targets[(c->draw + CAPTURE_TARGETS - 1) % CAPTURE_TARGETS]);
+    SDL_SetRenderTarget(renderer, NULL);
+    c->pending = true;
+    c->draw = (c->draw + 1) % CAPTURE_TARGETS;
+    c->frames += 1;
+    return ok;
+}
+
+bool capture_close(Capture* c) {
+    bool ok = true;
+    if (c->pending && c->thread != NULL) {
+        ok = read_back(c, c->renderer, c->targets[(c->draw + CAPTURE_TARGETS - 1) % CAPTURE_TARGETS]);
+        c->pending = false;
+    }
+    if (c->thread != NULL) {
+        SDL_LockMutex(c->lock);
+        c->quit = true;
+        SDL_BroadcastCondition(c->changed);
+        SDL_UnlockMutex(c->lock);
+        SDL_WaitThread(c->thread, NULL);
+        c->thread = NULL;
+    }
+    if (c->failed) ok = false;
+    if (c->fp != NULL) {
+        if (fflush(c->fp) != 0) ok = false;
+        if ((c->pipe ? pclose(c->fp) : fclose(c->fp)) != 0) ok = false;
+        c->fp = NULL;
+    }
+    for (int i = 0; i < CAPTURE_TARGETS; i++) {
+        if (c->targets[i]) SDL_DestroyTexture(c->targets[i]);
+    }
+    if (c->changed) SDL_DestroyCondition(c->changed);
+    if (c->lock) SDL_DestroyMutex(c->lock);
+    for (int i = 0; i < CAPTURE_SLOTS; i++) free(c->slots[i].rgba);
+    free(c->yuv);
+    memset(c, 0, sizeof(*c));
+    return ok;
+}
@@ -0,0 +1,54 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdio.h>
+#include <SDL3/SDL.h>
+
+#define CAPTURE_SLOTS 2
+#define CAPTURE_TARGETS 2
+
+typedef enum {
+    CAPTURE_Y4M,    // YUV4MPEG2, 4:2:0 full range, what encoders take on a pipe without flags
+    CAPTURE_RAW,    // bare RGBA frames: ffmpeg -f rawvideo -pix_fmt rgba -s WxH -r fps -i file
+} CaptureFormat;
+
+typedef struct {
+    uint8_t* rgba;
+    bool full;
+} CaptureSlot;
+
+// Frames are drawn into CAPTURE_TARGETS offscreen textures in turn. Frame n-1 is read back only
+// after frame n has been queued into the other one, into one of CAPTURE_SLOTS buffers that a
+// writer thread converts and writes. The renderer only waits when the writer is a full buffer
+// behind, so writing frame n-1 overlaps drawing frame n
+typedef struct {
+    FILE* fp;
+    bool pipe;
+    CaptureFormat format;
+    int w;
+    int h;
+    SDL_Renderer* renderer;
+    SDL_Texture* targets[CAPTURE_TARGETS];
+    int draw;               // target the next frame is drawn into
+    bool pending;           // the previous target holds a frame not read back yet
+    SDL_PixelFormat read_format;    // what SDL_RenderReadPixels() hands back, probed once
+    CaptureSlot slots[CAPTURE_SLOTS];
+    int fill;               // slot the next frame is read back into
+    uint8_t* yuv;           // writer thread scratch
+    SDL_Thread* thread;
+    SDL_Mutex* lock;
+    SDL_Condition* changed;
+    bool quit;
+    bool failed;
+    uint64_t frames;
+} Capture;
+
+// dest is a file (".y4m" for Y4M, anything else raw RGBA) or "|command" to pipe Y4M into an encoder
+bool capture_open(Capture* c, SDL_Renderer* renderer, const char* dest, int w, int h, int fps);
+// points the renderer at the capture target; draw the frame between begin and end
+void capture_begin_frame(Capture* c, SDL_Renderer* renderer);
+bool capture_end_frame(Capture* c, SDL_Renderer* renderer);
+// reads back the last frame, waits for the writer to drain, returns false if any frame failed to write
+bool capture_close(Capture* c);
+
+#endif
@@ -0,0 +1,91 @@
+#include "config.h"
+#include "render.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CONFIG_LINE 128
+
+void config_defaults(GameConfig* c) {
+    c->tick_rate = 60;
+    c->fps = 120;
+    c->time_scale = 1.0;
+    c->pacing = PACE_VSYNC;
+    c->render_scale = 0.0f;
+}
+
+static bool parse_int(const char* value, int lo, int hi, int* out) {
+    char* end;
+    long v = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || v < lo || v > hi) return false;
+    *out = (int)v;
+    return true;
+}
+
+bool config_set(GameConfig* c, const char* key, const char* value) {
+    if (strcmp(key, "tick-rate") == 0) {
+        if (parse_int(value, 10, 1000, &c->tick_rate)) return true;
+        printf("Error_config: tick-rate must be 10..1000, got '%s'\n", value);
+        return false;
+    }
+    if (strcmp(key, "fps") == 0) {
+        if (parse_int(value, 10, 1000, &c->fps)) return true;
+        printf("Error_config: fps must be 10..1000, got '%s'\n", value);
+        return false;
+    }
+    if (strcmp(key, "time-scale") == 0) {
+        char* end;
+        double v = strtod(value, &end);
+        if (end != value && *end == '\0' && v >= 0.05 && v <= 100.0) {
+            c->time_scale = v;
+            return true;
+        }
+        printf("Error_config: time-scale must be 0.05..100, got '%s'\n", value);
+        return false;
+    }
+    if (strcmp(key, "pacing") == 0) {
+        return pacing_parse_mode(value, &c->pacing);
+    }
+    if (strcmp(key, "render-scale") == 0) {
+        char* end;
+        double v = strtod(value, &end);
+        if (strcmp(value, "auto") == 0) {
+            c->render_scale = 0.0f;
+            return true;
+        }
+        if (end != value && *end == '\0' && v >= RENDER_SCALE_MIN && v <= RENDER_SCALE_MAX) {
+            c->render_scale = (float)v;
+            return true;
+        }
+        printf("Error_config: render-scale must be auto or %.2g..%.2g, got '%s'\n", RENDER_SCALE_MIN, RENDER_SCALE_MAX, value);
+        return false;
+    }
+    printf("Error_config: unknown setting '%s'\n", key);
+    return false;
+}
+
+bool config_load(GameConfig* c, const char* path, bool required) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        if (required) printf("Error_config: could not open %s\n", path);
+        return !required;
+    }
+
+    char line[CONFIG_LINE];
+    char key[32], value[64];
+    int line_no = 0;
+    bool ok = true;
+    while (fgets(line, sizeof(line), fp)) {
+        line_no += 1;
+        char* hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        int n = sscanf(line, "%31s %63s", key, value);
+        if (n <= 0) continue;
+        if (n != 2 || !config_set(c, key, value)) {
+            printf("Error_config: %s:%d\n", path, line_no);
+            ok = false;
+        }
+    }
+    fclose(fp);
+    return ok;
+}
@@ -0,0 +1,30 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include "pacing.h"
+
+#define CONFIG_FILE "breakout.cfg"
+
+// runtime timing knobs. Settings come from CONFIG_FILE (or --config), then the command line;
+// both use the same keys, one "key value" pair per line in the file and --key value on the
+// command line:
+//   tick-rate 60     sim steps per simulated second
+//   fps 120          frame cap for hybrid pacing
+//   time-scale 1     simulated seconds per real second
+//   pacing vsync     vsync | hybrid | uncapped
+//   render-scale auto    internal pixels per game pixel, auto adapts it to frame time
+typedef struct {
+    int tick_rate;
+    int fps;
+    double time_scale;
+    PaceMode pacing;
+    float render_scale;     // 0 = auto
+} GameConfig;
+
+void config_defaults(GameConfig* c);
+// false (with a message) for unknown keys or out-of-range values
+bool config_set(GameConfig* c, const char* key, const char* value);
+// a missing file is only an error when required is set
+bool config_load(GameConfig* c, const char* path, bool required);
+
+#endif
@@ -0,0 +1,308 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sim.h"
+#include "replay.h"
+#include "bot.h"
+#include "level.h"
+#include "snapshot.h"
+#include "versus.h"
+
+#define HEADLESS_HZ 60
+#define NS_PER_SECOND 1000000000ull
+
+#define REWIND_EVERY 997
+
+// with rewind set, every REWIND_EVERY ticks the world is rolled back a varying number of ticks
+// from the snapshot ring and those ticks are stepped again, so the checksum only still matches
+// if a restore brings back exactly the state that was saved
+int replay_file(const char* path, const char* level_path, int level_index, bool rewind) {
+    Replay replay;
+    if (!replay_play_open(&replay, path)) return -1;
+
+    static SimWorld world;
+    sim_init(&world);
+    sim_seed(&world, replay.seed);
+    if (replay.tick_rate == 0) {
+        printf("Error - replay has no tick rate\n");
+        replay_play_close(&replay);
+        return -1;
+    }
+    if (level_path && !level_load(&world, level_path, level_index)) {
+        replay_play_close(&replay);
+        return -1;
+    }
+    if (replay.level_hash != world.bricks.level_hash) {
+        printf("Error - replay was recorded on a different level\n");
+        replay_play_close(&replay);
+        return -1;
+    }
+    double dt = 1.0 / replay.tick_rate;
+    SimInput in;
+    static SnapshotRing ring;
+    static SimInput inputs[SNAPSHOT_SLOTS];
+    snapshot_ring_init(&ring, SNAPSHOT_SLOTS);
+    long long rewinds = 0;
+
+    clock_t start = clock();
+    for (uint64_t t = 0; replay_play_tick(&replay, &in); t++) {
+        if (rewind) {
+            snapshot_ring_push(&ring, &world);
+            inputs[t % SNAPSHOT_SLOTS] = in;
+        }
+        sim_step(&world, &in, dt);
+        if (rewind && t % REWIND_EVERY == REWIND_EVERY - 1) {
+            int back = 1 + (int)((t / REWIND_EVERY * 61) % ring.count);
+            if (!snapshot_ring_rewind(&ring, &world, back)) {
+                printf("Error_rewind: could not restore %d ticks back at tick %llu\n", back, (unsigned long long)t);
+                replay_play_close(&replay);
+                return 1;
+            }
+            for (uint64_t u = t + 1 - back; u <= t; u++) {
+                snapshot_ring_push(&ring, &world);
+                sim_step(&world, &inputs[u % SNAPSHOT_SLOTS], dt);
+            }
+            rewinds += 1;
+        }
+    }
+    double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+    replay_play_close(&replay);
+
+    uint64_t checksum = sim_checksum(&world);
+    bool match = replay.ticks == replay.total_ticks && checksum == replay.checksum;
+    printf("replay: %llu/%llu ticks at %u Hz in %.3fs\n", (unsigned long long)replay.ticks,
+           (unsigned long long)replay.total_ticks, replay.tick_rate, elapsed);
+    if (rewind) printf("rewinds: %lld, snapshot %zu bytes\n", rewinds, sim_snapshot_size(&world));
+    printf("checksum: %016llx (recorded %016llx) %s\n", (unsigned long long)checksum,
+           (unsigned long long)replay.checksum, match ? "MATCH" : "MISMATCH");
+    return match ? 0 : 1;
+}
+
+// two bots play a versus match against each other over a loopback link with the given one-way
+// latency, jitter and loss, one frame per tick. Afterwards each side's copy of the other's
+// board must equal the other's own board, however much of it was predicted and rolled back
+int versus_loopback(long long ticks, uint32_t hz, int delay, double latency_ms, double jitter_ms, double loss,
+                    BotKind bot_kind, const char* level_path, int level_index) {
+    static NetLink links[2];
+    static SimWorld worlds[2];
+    static Versus sides[2];
+    Bot bots[2];
+    net_loopback_pair(&links[0], &links[1], latency_ms, jitter_ms, loss, 1);
+    for (int i = 0; i < 2; i++) {
+        sim_init(&worlds[i]);
+        if (level_path && !level_load(&worlds[i], level_path, level_index)) return -1;
+        versus_start(&sides[i], &links[i], &worlds[i], hz, delay, 0x5EED0000u + i);
+        bot_init(&bots[i], i == 0 ? bot_kind : BOT_SLOPPY, i + 1, 30);
+    }
+
+    // the clock starts at 1 s, an echo of 0 means no ping came back yet
+    uint64_t frame_ns = NS_PER_SECOND / hz;
+    uint64_t now = NS_PER_SECOND;
+    double resim_s = 0.0;
+    long long frames = 0;
+    // a quiet link must leave enough frames to drain what is still in flight
+    long long max_frames = ticks * 4 + 10 * hz;
+    clock_t start = clock();
+    for (; frames < max_frames; frames++, now += frame_ns) {
+        bool done = true;
+        for (int i = 0; i < 2; i++) {
+            Versus* v = &sides[i];
+            clock_t poll_start = clock();
+            uint64_t resim_before = v->stats.resim_ticks;
+            if (!versus_poll(v, now)) return -1;
+            if (v->stats.resim_ticks != resim_before) resim_s += (double)(clock() - poll_start) / CLOCKS_PER_SEC;
+            if (v->tick < ticks) {
+                if (versus_ready(v)) {
+                    SimInput in = bot_input(&bots[i], &worlds[i]);
+                    versus_step(v, &in);
+                } else {
+                    v->stats.stalls += 1;
+                }
+            }
+            versus_send(v, now);
+            done = done && v->tick == ticks && v->remote_until >= ticks;
+        }
+        if (done) break;
+    }
+    double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    bool match = true;
+    for (int i = 0; i < 2; i++) {
+        const Versus* v = &sides[i];
+        const VersusStats* st = &v->stats;
+        bool same = v->tick == ticks && v->remote_until >= ticks && sim_checksum(&v->remote) == sim_checksum(&worlds[1 - i]);
+        match = match && same && st->desync_tick == 0;
+        printf("side %d: tick %u, points %d vs %d, rtt %.1fms, stalls %llu, rollbacks %llu (max depth %d, %llu ticks resimulated), "
+               "syncs checked %llu, packets %llu/%llu %s\n", i, v->tick, worlds[i].points, v->remote.points, st->rtt_ms,
+               (unsigned long long)st->stalls, (unsigned long long)st->rollbacks, st->max_rollback_depth,
+               (unsigned long long)st->resim_ticks, (unsigned long long)st->sync_checks,
+               (unsigned long long)st->packets_sent, (unsigned long long)st->packets_received, same ? "MATCH" : "MISMATCH");
+    }
+    uint64_t resim_ticks = sides[0].stats.resim_ticks + sides[1].stats.resim_ticks;
+    printf("versus: %lld frames in %.3fs, resimulation %.3fs (%.2fus a tick)\n", frames, elapsed, resim_s,
+           resim_ticks ? resim_s * 1e6 / resim_ticks : 0.0);
+    return match ? 0 : 1;
+}
+
+// tops the pool back up to target balls fanned out above the paddle, so the sim always carries the load
+void stress_refill(SimWorld* w, int target) {
+    static unsigned spin = 0;
+    const Ball* from = &w->balls[0];
+    while (w->ball_count < target) {
+        spin = (spin + 1) % 17;
+        float vel_x = -0.8f + 0.1f * spin;
+        if (!sim_spawn_ball(w, from, vel_x == 0.0f ? 0.05f : vel_x, -1.0f)) break;
+    }
+}
+
+// A ball breaks a multiball brick and falls out through the floor within one long step, while the
+// balls it released are still in play. Those were spawned during the step, so it was not the last
+// ball: no life may be lost and the released balls play on. No bot reaches this at a playable tick
+// rate (a ball needs most of a second to get from the board to the floor), so the world is set
+// up directly rather than recorded
+int drain_check(void) {
+    static SimWorld world;
+    sim_init(&world);
+    sim_seed(&world, 1);
+    SimInput in = {.menu_yes = true};
+    sim_step(&world, &in, 1.0 / HEADLESS_HZ);
+    in = (SimInput) {.serve = true};
+    sim_step(&world, &in, 1.0 / HEADLESS_HZ);
+
+    // the bottom left brick, and the ball right below it heading up; the paddle waits on the far side
+    BrickField* f = &world.bricks;
+    int brick = (f->rows - 1) * f->cols;
+    f->type[brick] |= BRICK_FLAG_MULTI;
+    f->hp[brick] = 1;
+    Ball* ball = &world.balls[0];
+    ball->shape.x = f->x[brick] + 0.5f * (f->w[brick] - ball->shape.w);
+    ball->shape.y = f->y[brick] + f->h[brick] + 1.0f;
+    ball->prev = ball->shape;
+    ball->vel_x = 0.1f;
+    ball->vel_y = -1.0f;
+    world.player.shape.x = WIDTH - world.player.shape.w;
+
+    int lives = world.lives;
+    in = (SimInput) {0};
+    uint32_t events = sim_step(&world, &in, 1.0);
+    bool ok = !brick_alive(f, brick) && world.lives == lives && !(events & SIM_EVENT_LIFE_LOST)
+              && world.status == IN_PLAY && world.ball_count == world.params.multiball_spawn;
+    printf("drain check: brick %s, lives %d -> %d, %d balls in play, %s\n", brick_alive(f, brick) ? "standing" : "broken",
+           lives, world.lives, world.ball_count, ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    long long ticks = 10000000;
+    double hz = HEADLESS_HZ;
+    const char* record_path = NULL;
+    const char* replay_path = NULL;
+    const char* level_path = NULL;
+    int level_index = 0;
+    uint64_t seed = 0;
+    int stress = 0;
+    BotKind bot_kind = BOT_TRACKER;
+    int positional = 0;
+    bool rewind = false;
+    bool versus = false;
+    int delay = 2;
+    double latency_ms = 40.0;
+    double jitter_ms = 10.0;
+    double loss = 0.02;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--rewind") == 0) {
+            rewind = true;
+        } else if (strcmp(argv[i], "--check-drain") == 0) {
+            return drain_check();
+        } else if (strcmp(argv[i], "--versus") == 0) {
+            versus = true;
+        } else if (strcmp(argv[i], "--delay") == 0 && i + 1 < argc) {
+            delay = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--latency") == 0 && i + 1 < argc) {
+            latency_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--jitter") == 0 && i + 1 < argc) {
+            jitter_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) {
+            loss = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+            level_path = argv[++i];
+        } else if (strcmp(argv[i], "--level-index") == 0 && i + 1 < argc) {
+            level_index = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--stress") == 0 && i + 1 < argc) {
+            stress = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--bot") == 0 && i + 1 < argc) {
+            if (!bot_parse_kind(argv[++i], &bot_kind)) {
+                printf("Error_bot: unknown kind %s\n", argv[i]);
+                return -1;
+            }
+        } else if (positional == 0) {
+            ticks = atoll(argv[i]);
+            positional++;
+        } else {
+            hz = atof(argv[i]);
+        }
+    }
+    if (replay_path) return replay_file(replay_path, level_path, level_index, rewind);
+    // stress balls are spawned outside the recorded input, so a stress run cannot be replayed
+    if (ticks <= 0 || !(hz > 0.0) || ((record_path || versus) && hz != (uint32_t)hz) || stress < 0 || stress > SIM_MAX_BALLS
+        || (record_path && stress) || (versus && (record_path || stress || ticks > UINT32_MAX / 2))) {
+        printf("usage: %s [--record file | --stress balls] [--bot tracker|predict|sloppy] [--seed n]\n"
+               "       [--level pack [--level-index n]] [ticks] [tick_rate]\n"
+               "       %s --replay file [--rewind] [--level pack [--level-index n]]\n"
+               "       %s --versus [--delay ticks] [--latency ms] [--jitter ms] [--loss 0..1] [--bot kind] [ticks] [tick_rate]\n"
+               "       %s --check-drain\n",
+               argv[0], argv[0], argv[0], argv[0]);
+        return -1;
+    }
+    if (versus) return versus_loopback(ticks, (uint32_t)hz, delay, latency_ms, jitter_ms, loss, bot_kind, level_path, level_index);
+    double dt = 1.0 / hz;
+
+    static SimWorld world;
+    sim_init(&world);
+    sim_seed(&world, seed);
+    if (level_path && !level_load(&world, level_path, level_index)) return -1;
+    Bot bot;
+    bot_init(&bot, bot_kind, 0, 0);
+
+    Replay replay;
+    if (record_path && !replay_record_open(&replay, record_path, (uint32_t)hz, seed, world.bricks.level_hash)) return -1;
+
+    int games = 0;
+    int best_score = 0;
+    long long total_score = 0;
+    long long ball_ticks = 0;
+
+    clock_t start = clock();
+    for (long long t = 0; t < ticks; t++) {
+        SimInput in = bot_input(&bot, &world);
+        if (record_path) replay_record_tick(&replay, &in);
+        if (stress && world.status == IN_PLAY) stress_refill(&world, stress);
+        ball_ticks += world.ball_count;
+        uint32_t events = sim_step(&world, &in, dt);
+        if (events & SIM_EVENT_GAME_OVER) {
+            games += 1;
+            total_score += world.last_score;
+            if (world.last_score > best_score) best_score = world.last_score;
+        }
+    }
+    double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    if (record_path && !replay_record_close(&replay, sim_checksum(&world))) return -1;
+
+    printf("ticks: %lld (%.1f sim seconds)\n", ticks, ticks * dt);
+    printf("wall: %.3fs, %.2f Mticks/s\n", elapsed, elapsed > 0.0 ? (ticks / elapsed) / 1e6 : 0.0);
+    printf("games: %d, best score: %d, mean score: %.1f\n", games, best_score, games ? (double)total_score / games : 0.0);
+    if (stress) {
+        printf("balls: %.1f on average, %.2f Mball-ticks/s\n", (double)ball_ticks / ticks,
+               elapsed > 0.0 ? (ball_ticks / elapsed) / 1e6 : 0.0);
+    }
+    return 0;
+}
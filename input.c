@@ -0,0 +1,99 @@
+#include "input.h"
+#include <stdio.h>
+#include <string.h>
+
+static bool map_key(SDL_Keycode key, InputAction* action) {
+    switch (key) {
+        case SDLK_A:
+        case SDLK_LEFT:
+            *action = INPUT_LEFT;
+            return true;
+        case SDLK_D:
+        case SDLK_RIGHT:
+            *action = INPUT_RIGHT;
+            return true;
+        case SDLK_SPACE:
+            *action = INPUT_SERVE;
+            return true;
+        case SDLK_Y:
+            *action = INPUT_YES;
+            return true;
+        case SDLK_N:
+            *action = INPUT_NO;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// producer side, runs inside SDL's event pump
+static bool push_event(void* userdata, SDL_Event* e) {
+    InputQueue* q = userdata;
+    InputAction action;
+    if ((e->type != SDL_EVENT_KEY_DOWN && e->type != SDL_EVENT_KEY_UP) || !map_key(e->key.key, &action)) return true;
+
+    int head = SDL_GetAtomicInt(&q->head);
+    int tail = SDL_GetAtomicInt(&q->tail);
+    SDL_MemoryBarrierAcquire();
+    if (head - tail >= INPUT_QUEUE_SIZE) {
+        SDL_AddAtomicInt(&q->dropped, 1);
+        return true;
+    }
+    q->events[head & (INPUT_QUEUE_SIZE - 1)] = (InputEvent) {
+        .timestamp = e->key.timestamp,
+        .action = (uint8_t)action,
+        .down = e->type == SDL_EVENT_KEY_DOWN,
+    };
+    SDL_MemoryBarrierRelease();
+    SDL_SetAtomicInt(&q->head, head + 1);
+    return true;
+}
+
+bool input_queue_start(InputQueue* q) {
+    memset(q, 0, sizeof(*q));
+    if (!SDL_AddEventWatch(push_event, q)) {
+        printf("Error_input: %s\n", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+void input_queue_stop(InputQueue* q) {
+    SDL_RemoveEventWatch(push_event, q);
+    int dropped = SDL_GetAtomicInt(&q->dropped);
+    if (dropped > 0) printf("input queue overflowed, %d key events dropped\n", dropped);
+}
+
+void input_queue_apply(InputQueue* q, uint64_t until, SimInput* in) {
+    int tail = SDL_GetAtomicInt(&q->tail);
+    int head = SDL_GetAtomicInt(&q->head);
+    SDL_MemoryBarrierAcquire();
+    for (; tail != head; tail++) {
+        const InputEvent* ev = &q->events[tail & (INPUT_QUEUE_SIZE - 1)];
+        if (ev->timestamp > until) break;
+        switch ((InputAction)ev->action) {
+            case INPUT_LEFT:
+                in->move_left = ev->down;
+                break;
+            case INPUT_RIGHT:
+                in->move_right = ev->down;
+                break;
+            // edges: only presses count, the caller clears them once a tick has seen them
+            case INPUT_SERVE:
+                in->serve |= ev->down;
+                break;
+            case INPUT_YES:
+                in->menu_yes |= ev->down;
+                break;
+            case INPUT_NO:
+                in->menu_no |= ev->down;
+                break;
+        }
+    }
+    SDL_MemoryBarrierRelease();
+    SDL_SetAtomicInt(&q->tail, tail);
+}
+
+bool input_queue_empty(InputQueue* q) {
+    return SDL_GetAtomicInt(&q->head) == SDL_GetAtomicInt(&q->tail);
+}
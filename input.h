@@ -0,0 +1,42 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <SDL3/SDL.h>
+#include "sim.h"
+
+#define INPUT_QUEUE_SIZE 256    // power of two
+
+typedef enum {
+    INPUT_LEFT=0,
+    INPUT_RIGHT,
+    INPUT_SERVE,
+    INPUT_YES,
+    INPUT_NO,
+} InputAction;
+
+typedef struct {
+    uint64_t timestamp;     // SDL_GetTicksNS() timebase, from the OS event where SDL has it
+    uint8_t action;
+    bool down;
+} InputEvent;
+
+// Single-producer single-consumer ring of game key events. An SDL event watch pushes each key
+// event as SDL queues it (on the thread pumping events, SDL needs that to be the main thread),
+// the fixed-step loop pops them by timestamp so every press and release lands in the tick it
+// happened in rather than the tick after the next frame's poll. Each side only stores its own
+// index, published with a release barrier like the profiler ring
+typedef struct {
+    InputEvent events[INPUT_QUEUE_SIZE];
+    SDL_AtomicInt head;     // next slot the producer writes
+    SDL_AtomicInt tail;     // next slot the consumer reads
+    SDL_AtomicInt dropped;
+} InputQueue;
+
+bool input_queue_start(InputQueue* q);
+void input_queue_stop(InputQueue* q);
+// applies every queued event stamped at or before until to in, later ones stay queued
+void input_queue_apply(InputQueue* q, uint64_t until, SimInput* in);
+// true when every pushed event has been applied
+bool input_queue_empty(InputQueue* q);
+
+#endif
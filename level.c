@@ -0,0 +1,100 @@
+#include "level.h"
+#include <stdio.h>
+#include <string.h>
+
+_Static_assert(sizeof(LevelPackHeader) == 16, "pack header is read in place");
+_Static_assert(sizeof(LevelHeader) == 48, "level header is read in place");
+_Static_assert(sizeof(SimColor) == 4, "palette is read in place");
+
+const char level_magic[4] = {'2', '0', 'G', 'L'};
+
+size_t level_blob_size(int cells) {
+    size_t size = sizeof(LevelHeader) + sizeof(SimColor) * LEVEL_MAX_COLOURS + (size_t)cells * 4;
+    return (size + 7) & ~(size_t)7;
+}
+
+// FNV-1a over palette and the four cell arrays, so replays can tell which board they were made on
+uint64_t level_hash(const SimColor* palette, const uint8_t* cells, int cell_count) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    const uint8_t* p = (const uint8_t*)palette;
+    for (size_t i = 0; i < sizeof(SimColor) * LEVEL_MAX_COLOURS; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    for (int i = 0; i < cell_count * 4; i++) {
+        h ^= cells[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+// maps the pack and checks the header and offset table; levels themselves are only touched when picked
+bool level_pack_open(LevelPack* p, const char* path) {
+    memset(p, 0, sizeof(*p));
+    if (!mapped_open(&p->file, path)) {
+        printf("Error_level: could not map %s\n", path);
+        return false;
+    }
+    p->data = p->file.data;
+    p->size = p->file.size;
+
+    const LevelPackHeader* h = (const LevelPackHeader*)p->data;
+    if (p->size < sizeof(*h) || memcmp(h->magic, level_magic, sizeof(level_magic)) != 0 || h->version != LEVEL_VERSION) {
+        printf("Error_level: %s is not a version %d level pack\n", path, LEVEL_VERSION);
+        level_pack_close(p);
+        return false;
+    }
+    if (sizeof(*h) + sizeof(uint32_t) * h->level_count > p->size) {
+        printf("Error_level: %s is truncated\n", path);
+        level_pack_close(p);
+        return false;
+    }
+    p->count = h->level_count;
+    p->offsets = (const uint32_t*)(p->data + sizeof(*h));
+    return true;
+}
+
+void level_pack_close(LevelPack* p) {
+    mapped_close(&p->file);
+    p->data = NULL;
+    p->size = 0;
+    p->count = 0;
+}
+
+bool level_pack_get(const LevelPack* p, int index, Level* out) {
+    if (index < 0 || index >= p->count) {
+        printf("Error_level: no level %d (pack has %d)\n", index, p->count);
+        return false;
+    }
+    size_t offset = p->offsets[index];
+    if (offset % 8 != 0 || offset + sizeof(LevelHeader) > p->size) {
+        printf("Error_level: level %d has a bad offset\n", index);
+        return false;
+    }
+    const LevelHeader* h = (const LevelHeader*)(p->data + offset);
+    if (h->cols == 0 || h->cols > BRICK_MAX_COLS || h->rows == 0 || h->rows > BRICK_MAX_ROWS ||
+        h->cell_count != (uint32_t)h->cols * h->rows || h->colour_count > LEVEL_MAX_COLOURS ||
+        offset + level_blob_size(h->cell_count) > p->size) {
+        printf("Error_level: level %d is malformed\n", index);
+        return false;
+    }
+
+    const uint8_t* cells = p->data + offset + sizeof(LevelHeader) + sizeof(SimColor) * LEVEL_MAX_COLOURS;
+    out->header = h;
+    out->palette = (const SimColor*)(p->data + offset + sizeof(LevelHeader));
+    out->type = cells;
+    out->hp = cells + h->cell_count;
+    out->colour = cells + 2 * h->cell_count;
+    out->points = cells + 3 * h->cell_count;
+    return true;
+}
+
+bool level_load(SimWorld* w, const char* path, int index) {
+    LevelPack pack;
+    Level lv;
+    if (!level_pack_open(&pack, path)) return false;
+    bool ok = level_pack_get(&pack, index, &lv);
+    if (ok) sim_load_level(w, &lv);
+    level_pack_close(&pack);
+    return ok;
+}
@@ -0,0 +1,63 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include <stddef.h>
+#include "sim.h"
+#include "mapped.h"
+
+#define LEVEL_VERSION 1
+#define LEVEL_NAME_LEN 32
+#define LEVEL_MAX_COLOURS 16
+
+// A level pack is used in place once mapped, so every block is 8-byte aligned and little endian:
+//   LevelPackHeader, u32 offset[level_count] (from the start of the file), then for each level
+//   LevelHeader, SimColor palette[LEVEL_MAX_COLOURS], u8 type[n], u8 hp[n], u8 colour[n], u8 points[n]
+// where n = cols * rows, cells are row-major and type uses the BRICK_* values from sim.h
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t level_count;
+    uint32_t reserved[2];
+} LevelPackHeader;
+
+typedef struct {
+    char name[LEVEL_NAME_LEN];
+    uint8_t cols;
+    uint8_t rows;
+    uint8_t colour_count;
+    uint8_t reserved;
+    uint32_t cell_count;
+    uint64_t hash;
+} LevelHeader;
+
+// pointers into a mapped pack, valid until level_pack_close()
+typedef struct Level {
+    const LevelHeader* header;
+    const SimColor* palette;
+    const uint8_t* type;
+    const uint8_t* hp;
+    const uint8_t* colour;
+    const uint8_t* points;
+} Level;
+
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    int count;
+    const uint32_t* offsets;
+    MappedFile file;
+} LevelPack;
+
+extern const char level_magic[4];
+
+size_t level_blob_size(int cells);
+uint64_t level_hash(const SimColor* palette, const uint8_t* cells, int cell_count);
+
+bool level_pack_open(LevelPack* p, const char* path);
+void level_pack_close(LevelPack* p);
+bool level_pack_get(const LevelPack* p, int index, Level* out);
+
+// maps the pack just long enough to copy one level into w
+bool level_load(SimWorld* w, const char* path, int index);
+
+#endif
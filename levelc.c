@@ -0,0 +1,238 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "level.h"
+
+// Compiles text level sources into one binary pack (see level.h). Source format, one level per
+// "level ... end" block, '#' starts a comment:
+//
+//   level classic
+//   key R 154 78 78 7 1 fast      # cell char, colour, points, hits to break, flags (solid, fast, multi)
+//   key X 90 90 90 0 0 solid
+//   grid                          # one line per row, '.' or ' ' is an empty cell
+//   RRRR..RRRR
+//   XXXX..XXXX
+//   end
+
+#define LEVELC_MAX_LEVELS 1024
+#define LEVELC_LINE 256
+
+typedef struct {
+    bool used;
+    uint8_t type;
+    uint8_t hp;
+    uint8_t colour;
+    uint8_t points;
+} CellKey;
+
+typedef struct {
+    LevelHeader header;
+    SimColor palette[LEVEL_MAX_COLOURS];
+    uint8_t cells[4][BRICK_MAX_COLS * BRICK_MAX_ROWS];
+} CompiledLevel;
+
+static CompiledLevel levels[LEVELC_MAX_LEVELS];
+static int level_count = 0;
+
+static void trim_comment(char* line) {
+    char* c = strchr(line, '#');
+    if (c) *c = '\0';
+    size_t n = strlen(line);
+    while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r' || line[n - 1] == ' ' || line[n - 1] == '\t')) line[--n] = '\0';
+}
+
+static int palette_index(CompiledLevel* lv, SimColor c) {
+    for (int i = 0; i < lv->header.colour_count; i++) {
+        SimColor p = lv->palette[i];
+        if (p.r == c.r && p.g == c.g && p.b == c.b && p.a == c.a) return i;
+    }
+    if (lv->header.colour_count >= LEVEL_MAX_COLOURS) return -1;
+    lv->palette[lv->header.colour_count] = c;
+    return lv->header.colour_count++;
+}
+
+static bool finish_level(CompiledLevel* lv, const char* path, int line_no) {
+    lv->header.cell_count = (uint32_t)lv->header.cols * lv->header.rows;
+
+    // cells were stored at the full row stride while parsing, pack them down to cols x rows
+    for (int a = 0; a < 4; a++) {
+        for (int y = 0; y < lv->header.rows; y++) {
+            memmove(&lv->cells[a][y * lv->header.cols], &lv->cells[a][y * BRICK_MAX_COLS], lv->header.cols);
+        }
+    }
+
+    int breakable = 0;
+    for (uint32_t i = 0; i < lv->header.cell_count; i++) {
+        if (lv->cells[0][i] != BRICK_EMPTY && (lv->cells[0][i] & BRICK_TYPE_MASK) != BRICK_SOLID) breakable += 1;
+    }
+    if (breakable == 0) {
+        printf("Error_levelc: %s:%d level '%s' has no breakable bricks\n", path, line_no, lv->header.name);
+        return false;
+    }
+    uint8_t flat[4 * BRICK_MAX_COLS * BRICK_MAX_ROWS];
+    for (int a = 0; a < 4; a++) {
+        memcpy(&flat[a * lv->header.cell_count], lv->cells[a], lv->header.cell_count);
+    }
+    lv->header.hash = level_hash(lv->palette, flat, (int)lv->header.cell_count);
+    return true;
+}
+
+static bool compile_file(const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        printf("Error_levelc: could not open %s\n", path);
+        return false;
+    }
+
+    char line[LEVELC_LINE];
+    CellKey keys[256];
+    CompiledLevel* lv = NULL;
+    bool in_grid = false;
+    bool ok = true;
+    int line_no = 0;
+
+    while (ok && fgets(line, sizeof(line), fp)) {
+        line_no += 1;
+        trim_comment(line);
+
+        if (in_grid) {
+            if (strcmp(line, "end") == 0) {
+                in_grid = false;
+                ok = finish_level(lv, path, line_no);
+                lv = NULL;
+                continue;
+            }
+            int cols = (int)strlen(line);
+            if (cols == 0) continue;
+            if (cols > BRICK_MAX_COLS || lv->header.rows >= BRICK_MAX_ROWS) {
+                printf("Error_levelc: %s:%d board larger than %d x %d\n", path, line_no, BRICK_MAX_COLS, BRICK_MAX_ROWS);
+                ok = false;
+                break;
+            }
+            if (cols > lv->header.cols) lv->header.cols = (uint8_t)cols;
+            for (int x = 0; x < cols; x++) {
+                unsigned char ch = (unsigned char)line[x];
+                int i = lv->header.rows * BRICK_MAX_COLS + x;
+                if (ch == '.' || ch == ' ') continue;
+                if (!keys[ch].used) {
+                    printf("Error_levelc: %s:%d unknown cell '%c'\n", path, line_no, ch);
+                    ok = false;
+                    break;
+                }
+                lv->cells[0][i] = keys[ch].type;
+                lv->cells[1][i] = keys[ch].hp;
+                lv->cells[2][i] = keys[ch].colour;
+                lv->cells[3][i] = keys[ch].points;
+            }
+            lv->header.rows += 1;
+            continue;
+        }
+
+        char word[16];
+        if (sscanf(line, "%15s", word) != 1) continue;
+
+        if (strcmp(word, "level") == 0) {
+            if (lv != NULL || level_count >= LEVELC_MAX_LEVELS) {
+                printf("Error_levelc: %s:%d unexpected 'level'\n", path, line_no);
+                ok = false;
+                break;
+            }
+            lv = &levels[level_count++];
+            memset(lv, 0, sizeof(*lv));
+            memset(keys, 0, sizeof(keys));
+            const char* name = line + strlen("level");
+            while (*name == ' ' || *name == '\t') name++;
+            size_t len = strlen(name);
+            memcpy(lv->header.name, name, len < LEVEL_NAME_LEN - 1 ? len : LEVEL_NAME_LEN - 1);
+        } else if (strcmp(word, "key") == 0 && lv != NULL) {
+            char ch;
+            int r, g, b, points, hp, used = 0;
+            if (sscanf(line, "key %c %d %d %d %d %d %n", &ch, &r, &g, &b, &points, &hp, &used) < 6 || used == 0) {
+                printf("Error_levelc: %s:%d expected: key <char> <r> <g> <b> <points> <hp> [solid] [fast] [multi]\n", path, line_no);
+                ok = false;
+                break;
+            }
+            CellKey* k = &keys[(unsigned char)ch];
+            k->used = true;
+            k->type = strstr(line + used, "solid") ? BRICK_SOLID : BRICK_NORMAL;
+            if (strstr(line + used, "fast")) k->type |= BRICK_FLAG_FAST;
+            if (strstr(line + used, "multi")) k->type |= BRICK_FLAG_MULTI;
+            k->hp = (uint8_t)(hp < 0 ? 0 : hp > 255 ? 255 : hp);
+            k->points = (uint8_t)(points < 0 ? 0 : points > 255 ? 255 : points);
+            int colour = palette_index(lv, (SimColor) {(uint8_t)r, (uint8_t)g, (uint8_t)b, 255});
+            if (colour < 0) {
+                printf("Error_levelc: %s:%d more than %d colours\n", path, line_no, LEVEL_MAX_COLOURS);
+                ok = false;
+                break;
+            }
+            k->colour = (uint8_t)colour;
+        } else if (strcmp(word, "grid") == 0 && lv != NULL) {
+            in_grid = true;
+        } else {
+            printf("Error_levelc: %s:%d unexpected '%s'\n", path, line_no, word);
+            ok = false;
+        }
+    }
+    if (ok && lv != NULL) {
+        printf("Error_levelc: %s: level '%s' is missing 'end'\n", path, lv->header.name);
+        ok = false;
+    }
+    fclose(fp);
+    return ok;
+}
+
+static void write_zeros(FILE* fp, size_t n) {
+    for (size_t i = 0; i < n; i++) fputc(0, fp);
+}
+
+static bool write_pack(const char* path) {
+    FILE* fp = fopen(path, "wb");
+    if (!fp) {
+        printf("Error_levelc: could not create %s\n", path);
+        return false;
+    }
+
+    LevelPackHeader h = {.version = LEVEL_VERSION, .level_count = (uint16_t)level_count};
+    memcpy(h.magic, level_magic, sizeof(h.magic));
+    fwrite(&h, sizeof(h), 1, fp);
+
+    size_t table = sizeof(uint32_t) * level_count;
+    size_t offset = (sizeof(h) + table + 7) & ~(size_t)7;
+    for (int i = 0; i < level_count; i++) {
+        uint32_t o = (uint32_t)offset;
+        fwrite(&o, sizeof(o), 1, fp);
+        offset += level_blob_size((int)levels[i].header.cell_count);
+    }
+    write_zeros(fp, ((sizeof(h) + table + 7) & ~(size_t)7) - (sizeof(h) + table));
+
+    for (int i = 0; i < level_count; i++) {
+        const CompiledLevel* lv = &levels[i];
+        uint32_t n = lv->header.cell_count;
+        fwrite(&lv->header, sizeof(lv->header), 1, fp);
+        fwrite(lv->palette, sizeof(lv->palette), 1, fp);
+        for (int a = 0; a < 4; a++) fwrite(lv->cells[a], 1, n, fp);
+        write_zeros(fp, level_blob_size((int)n) - (sizeof(lv->header) + sizeof(lv->palette) + 4 * n));
+    }
+
+    bool ok = !ferror(fp);
+    if (fclose(fp) != 0) ok = false;
+    if (!ok) printf("Error_levelc: could not write %s\n", path);
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        printf("usage: %s out.pak level.txt [level.txt ...]\n", argv[0]);
+        return -1;
+    }
+    for (int i = 2; i < argc; i++) {
+        if (!compile_file(argv[i])) return 1;
+    }
+    if (!write_pack(argv[1])) return 1;
+
+    for (int i = 0; i < level_count; i++) {
+        printf("%3d %-31s %2d x %-2d %016llx\n", i, levels[i].header.name, levels[i].header.cols,
+               levels[i].header.rows, (unsigned long long)levels[i].header.hash);
+    }
+    return 0;
+}
@@ -3,44 +3,36 @@
 #include <SDL3_ttf/SDL_ttf.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
-
-#define TARGET_FPS 120
-#define TARGET_DT (1.0 / TARGET_FPS)
-#define WIDTH 960
-#define HEIGHT 700
-
-#define PADDLE_W WIDTH * 0.18
-#define PADDLE_H HEIGHT * 0.03
-
-#define BALL_SIZE 10
-#define MIN_BALL_SPEED HEIGHT * 0.5
-
-#define BLOCK_COLS 8
-#define BLOCK_ROWS 14
-#define BLOCK_X_OFFSET 2
-#define BLOCK_Y_OFFSET 2
-#define BLOCK_W (WIDTH - BLOCK_ROWS * BLOCK_X_OFFSET) / (BLOCK_ROWS)
-#define BLOCK_H ((float)HEIGHT / 3) / (BLOCK_COLS)
-#define BLOCK_W_GAP (float) (WIDTH - ((float)BLOCK_ROWS * BLOCK_W))
-#define BLOCK_COLLISION_ANGLE 0.3f
-#define RED_POINTS 7
-#define PINK_POINTS 5
-#define GREEN_POINTS 3
-#define YELLOW_POINTS 1
-
-#define HOTBAR_H 40
-#define MAX_LIVES 3
-#define MAX_SCORE (2 * BLOCK_ROWS) * (RED_POINTS + PINK_POINTS + GREEN_POINTS + YELLOW_POINTS)
-
-const char* save_file = ".\\save_file.txt";
+#include <string.h>
+#include "sim.h"
+#include "text.h"
+#include "render.h"
+#include "replay.h"
+#include "level.h"
+#include "profiler.h"
+#include "pacing.h"
+#include "save.h"
+#include "config.h"
+#include "capture.h"
+#include "input.h"
+#include "arena.h"
+#include "snapshot.h"
+#include "net.h"
+#include "versus.h"
+#include "particles.h"
+
+// most simulated time one frame may catch up on before the backlog is dropped (8 ticks at 60 Hz)
+#define MAX_CATCHUP_S 0.125
+#define BRICK_SPARKS 40
+#define PADDLE_SPARKS 12
+
+// longest an idle frame sleeps on the event queue when no game clock is running
+#define IDLE_WAKE_MS 1000
+// how far R can rewind, capped at SNAPSHOT_SLOTS ticks (17 s at 120 Hz)
+#define REWIND_SECONDS 10
+
 SDL_Color off_black = {33, 33, 33, 255};
 SDL_Color black = {10, 10, 10, 255};
-SDL_Color yellow = {187, 165, 59};
-SDL_Color green = {99, 141, 91, 255};
-SDL_Color pink = {179, 100, 138};
-SDL_Color red = {154, 78, 78};
-SDL_Color grey = {195, 195, 195, 255};
 SDL_Color white = {220, 220, 220, 255};
 char* font_path = ".\\fonts\\FiraCode-Bold.ttf";
 
@@ -55,305 +47,246 @@ typedef enum {
 
 
 typedef enum {
-    IN_MENU,
-    RESET_ROUND,
-    GAME_OVER,
-    IN_PLAY,
-} PlayStatus;
-
-typedef struct {
-    int minutes;
-    int seconds;
-    time_t previous_time;
-} Timer;
+    REPLAY_OFF,
+    REPLAY_RECORDING,
+    REPLAY_PLAYBACK,
+} ReplayMode;
 
-typedef struct {
-    SDL_FRect shape;
-    SDL_Color colour;
-    float velocity;
-    float move_speed;
-    bool move_left;
-    bool move_right;
-    bool game_started;
-    bool half_size;
-} Player;
-
-typedef struct {
-    SDL_FRect shape;
-    float vel_x;
-    float vel_y;
-    float move_speed;
-    float speed_modifier;
-} Ball;
-
-typedef struct {
-    SDL_FRect shape;
-    bool alive;
-    SDL_Color color;
-    int points;
-} Block;
+#define UI_TEXT_LEN 24
 
+// a hotbar string and the glyph quads last built for it; quads are only rebuilt when the text changes
 typedef struct {
     UIType id;
-    SDL_Texture* texture;
+    char text[UI_TEXT_LEN];
     float x;
     float y;
+    SDL_Vertex quads[UI_TEXT_LEN * 4];
+    int quad_count;
 } TextElements;
 
 typedef struct {
     SDL_Window* window;
     SDL_Renderer* renderer;
-    TTF_TextEngine* text_engine;
-    Player player;
-    Ball ball;
-    PlayStatus status;
-    Block blocks[BLOCK_COLS][BLOCK_ROWS];
+    SDL_Surface* canvas;    // software render surface when capturing, there is no window then
+    Capture capture;
+    bool capturing;
+    RenderScaler scaler;    // window frames go through it, captures are drawn at WIDTH x HEIGHT
+    SimWorld world;
+    SimInput input;
+    InputQueue input_queue;
     SDL_FRect hotbar;
-    int points;
-    int lives;
     int hiscore;
+    SaveData save;
+    Saver saver;
     TextElements ui_elements[MAX_UITypes];
-    TTF_Font* font;
-    int brick_count;
-    int consecutive_hits;
-    bool first_hit_pink_or_red;
-    bool first_hit_top_wall;
-    Timer time;
-    TTF_Text* menu_text;
-    TTF_Text* menu_score_text;
+    GlyphAtlas atlas;
+    ShapeBatch shapes;
+    ParticleSystem particles;
+    char menu_score_text[32];
+    ReplayMode replay_mode;
+    Replay replay;
+    Profiler profiler;
+    Pacer pacer;
+    GameConfig config;
+    SimRect prev_paddle;
+    SnapshotRing history;   // one snapshot per tick for rewinding, cleared at game over
+    bool rewinding;         // R held
+    bool versus_on;         // --versus: racing a rival cabinet, see versus.h
+    NetLink link;
+    Versus versus;
+    float alpha;
+    bool damaged;           // something changed since the last drawn frame, see scene_idle()
+    bool show_perf;
+    char perf_text[96];
+    uint32_t play_allocs;   // heap allocations made in frames spent in play, should stay 0
 } GameState;
 
 GameState *game = NULL;
 
-void populate_ui_textures(UIType i) {
-    TTF_SetFontSize(game->font, 16);
-    SDL_Surface* s;
-    switch (i) {
-        case LIVES: {
-                char buffer[15];
-                sprintf(buffer, "Lives: %d", game->lives);
-                s = TTF_RenderText_Blended(game->font, buffer, 0, white);
-                game->ui_elements[LIVES].x = 0;
-                game->ui_elements[LIVES].y = 0;
-                break;
-            }
-        case POINTS: {
-                char buffer[15];
-                sprintf(buffer, "Points: %d", game->points);
-                s = TTF_RenderText_Blended(game->font, buffer, 0, white);
-                game->ui_elements[POINTS].x = 0.2f*WIDTH;
-                game->ui_elements[POINTS].y = 0;
-                break;   
-            }
-        case TIME: {
-                char buffer[10];
-                sprintf(buffer, "%02d:%02d", game->time.minutes, game->time.seconds);
-                if (game->time.minutes > 99) sprintf(buffer, "just stop");
-                s = TTF_RenderText_Blended(game->font, buffer, 0, white);
-                game->ui_elements[TIME].x = 0.5f*WIDTH;
-                game->ui_elements[TIME].y = 0;
-                break; 
-            }
-        case HIGH_SCORE: {
-                char buffer[20];
-                sprintf(buffer, "High Score: %03d", game->hiscore);
-                s = TTF_RenderText_Blended(game->font, buffer, 0, white);
-                game->ui_elements[HIGH_SCORE].x = 0.75 * WIDTH;
-                game->ui_elements[HIGH_SCORE].y = 0;
-                break;
-            }  
-        default:
-            return;
-    }
+// all per-session memory: GameState holds the world, UI text, glyph and shape batches and the
+// save record at fixed sizes, so after startup nothing in the game loop allocates
+static uint8_t session_memory[ARENA_BYTES(sizeof(GameState))];
+static Arena session;
 
-    if (s == NULL) {
-        printf("Error_surface_text\n");
-        return;
-    }
+// wall time of each startup step, printed once the first frame is up
+#define MAX_STARTUP_PHASES 8
+typedef struct {
+    const char* name;
+    uint64_t ns;
+} StartupPhase;
+
+static StartupPhase startup_phases[MAX_STARTUP_PHASES];
+static int startup_count = 0;
+static uint64_t startup_start = 0;
+static uint64_t startup_last = 0;
+
+// charges the time since the previous phase ended to `name`
+void startup_phase(const char* name) {
+    uint64_t now = SDL_GetTicksNS();
+    if (startup_count < MAX_STARTUP_PHASES) startup_phases[startup_count++] = (StartupPhase) {name, now - startup_last};
+    startup_last = now;
+}
 
-    if (game->ui_elements[i].texture) {
-        SDL_DestroyTexture(game->ui_elements[i].texture);
+void print_startup(void) {
+    printf("startup: %.1f ms to first frame (", (startup_last - startup_start) / 1e6);
+    for (int i = 0; i < startup_count; i++) {
+        printf("%s%s %.1f", i ? ", " : "", startup_phases[i].name, startup_phases[i].ns / 1e6);
     }
-    
-    game->ui_elements[i].texture = SDL_CreateTextureFromSurface(game->renderer, s);
-    SDL_DestroySurface(s);
-    return;    
+    printf(" ms)\n");
 }
 
-int load_save_file(void) {
-    FILE* fp = fopen(save_file, "a+");
-    if (!fp) {
-        printf("Error loading file_load..\n");
-        return -1;
-    }
-    int hi_score;
-    int ret_code = fscanf(fp, "%d\n", &hi_score);
-    if (ret_code < 1) {
-        hi_score = 0;
-        rewind(fp);
-        fprintf(fp, "%d", hi_score);
-    }
-    if (hi_score > MAX_SCORE || hi_score < 0) {
-        printf("invalid high score. resetting to 0\n");
-        hi_score = 0;
+// returns true when the element's text actually changed and its quads were rebuilt
+bool populate_ui_text(UIType i) {
+    TextElements* el = &game->ui_elements[i];
+    char text[UI_TEXT_LEN];
+    switch (i) {
+        case LIVES:
+            snprintf(text, sizeof(text), "Lives: %d", game->world.lives);
+            el->x = 0;
+            break;
+        case POINTS:
+            snprintf(text, sizeof(text), "Points: %d", game->world.points);
+            el->x = 0.2f*WIDTH;
+            break;
+        case TIME:
+            snprintf(text, sizeof(text), "%02d:%02d", game->world.time.minutes, game->world.time.seconds);
+            if (game->world.time.minutes > 99) snprintf(text, sizeof(text), "just stop");
+            el->x = 0.5f*WIDTH;
+            break;
+        case HIGH_SCORE:
+            snprintf(text, sizeof(text), "High Score: %03d", game->hiscore);
+            if (game->versus_on) snprintf(text, sizeof(text), "Rival: %03d", game->versus.remote.points);
+            el->x = 0.75 * WIDTH;
+            break;
+        default:
+            text[0] = '\0';
+            break;
     }
-    
-    fclose(fp); 
-    
-    return hi_score;
+    el->y = 0;
+    if (strcmp(text, el->text) == 0) return false;
+
+    memcpy(el->text, text, sizeof(text));
+    game->damaged = true;
+    float w, h;
+    text_measure(&game->atlas, FONT_SMALL, el->text, &w, &h);
+    float x = el->x + (0.5f * BLOCK_W_GAP + BLOCK_X_OFFSET);
+    float y = el->y + (0.5f * (HOTBAR_H - h));
+    el->quad_count = text_build(&game->atlas, FONT_SMALL, el->text, x, y, white, el->quads, UI_TEXT_LEN);
+    return true;
 }
 
-void update_hiscore(void) {
-    if (game->points < game->hiscore) {
-        return;
-    }
-    if (game->points > MAX_SCORE) {
+// files the finished game in the save record and hands the write to the save thread
+void record_game(void) {
+    const SimWorld* w = &game->world;
+    int score = w->last_score;
+    if (score > w->bricks.max_score) {
         printf("Error - high score too high\n");
-        game->points =  MAX_SCORE;
         return;
     }
-
-    if (game->points < 0) {
+    if (score < 0) {
         printf("Error - high score too low\n");
-        game->points = 0;
         return;
     }
 
-    game->hiscore = game->points;
-    
-    FILE* fp = fopen(save_file, "w");
-    if (!fp) {
-        printf("Error loading file_update...\n");
-        return;
-    }
-    fprintf(fp,"%d", game->points);
-    fclose(fp);
-    populate_ui_textures(HIGH_SCORE);
-    return;
+    SaveGame g = {
+        .score = score,
+        .seconds = w->last_time.minutes * 60 + w->last_time.seconds,
+        .lives_lost = MAX_LIVES - w->last_lives,
+        .cleared = w->last_lives > 0,
+        .level_hash = w->bricks.level_hash,
+    };
+    SDL_Time now;
+    if (SDL_GetCurrentTime(&now)) g.when = now;
+    save_record_game(&game->save, &g);
+    save_write(&game->saver, &game->save);
+
+    game->hiscore = save_best_score(&game->save);
+    populate_ui_text(HIGH_SCORE);
 }
 
-bool gamestate_create() {
-    game = malloc(sizeof(GameState));
+bool gamestate_create(const GameConfig* config, bool offscreen) {
+    arena_init(&session, session_memory, sizeof(session_memory));
+    game = arena_push(&session, sizeof(GameState));
+    if (game == NULL) return false;
+    game->config = *config;
+    game->saver = (Saver) {0};
+    game->replay_mode = REPLAY_OFF;
+    game->rewinding = false;
+    game->versus_on = false;
+    game->window = NULL;
+    game->canvas = NULL;
+    game->capturing = false;
 
-    game->window = SDL_CreateWindow("20g_breakout", WIDTH, HEIGHT, 0);
-    if (game->window == NULL) {
-        printf("Error_window: %s\n", SDL_GetError());
-        return false;
+    if (offscreen) {
+        game->canvas = SDL_CreateSurface(WIDTH, HEIGHT, SDL_PIXELFORMAT_XRGB8888);
+        game->renderer = game->canvas ? SDL_CreateSoftwareRenderer(game->canvas) : NULL;
+    } else {
+        // sim coordinates stay WIDTH x HEIGHT whatever the window's size or pixel density
+        game->window = SDL_CreateWindow("20g_breakout", WIDTH, HEIGHT, SDL_WINDOW_RESIZABLE | SDL_WINDOW_HIGH_PIXEL_DENSITY);
+        if (game->window == NULL) {
+            printf("Error_window: %s\n", SDL_GetError());
+            return false;
+        }
+        game->renderer = SDL_CreateRenderer(game->window, NULL);
     }
-    game->renderer = SDL_CreateRenderer(game->window, NULL);
     if (game->renderer == NULL) {
         printf("Error_renderer: %s\n", SDL_GetError());
         return false;
     }
-
-    game->font = TTF_OpenFont(font_path, 16);
-    if (game->font == NULL) {
-        printf("Error_font: %s\n", SDL_GetError());
+    if (!offscreen && !render_scaler_init(&game->scaler, game->renderer, config->render_scale, SDL_NS_PER_SECOND / (Uint64)config->fps)) {
         return false;
     }
 
-    game->text_engine = TTF_CreateRendererTextEngine(game->renderer);
-    if (game->text_engine == NULL) {
-        printf("Error_text_engine\n");
+    startup_phase("window");
+
+    // the atlas usually comes straight from the cache, the font is only rasterised when it changed
+    bool cached = false;
+    if (!glyph_atlas_load(&game->atlas, game->renderer, font_path, &cached)) {
         return false;
     }
+    startup_phase(cached ? "atlas (cached)" : "atlas (baked)");
 
-    game->menu_text = NULL;
-    game->menu_score_text = NULL;
-    game->hiscore = load_save_file();
-    game->time = (Timer) {.minutes = 0, .seconds = 0, .previous_time = 0};
-    game->brick_count = BLOCK_COLS * BLOCK_ROWS;
-    game->consecutive_hits = 0;
-    game->first_hit_pink_or_red = false;
-    game->first_hit_top_wall = false;
-    game->hotbar = (SDL_FRect) {.x = 0, .y = 0, .w = WIDTH, .h = HOTBAR_H};
-    game->status = IN_MENU;
-    game->points = 0;
-    game->lives = MAX_LIVES;
-    
-    game->player = (Player) {
-        .shape = (SDL_FRect) {.x = (WIDTH * 0.5f) - (PADDLE_W * 0.5f), .y = HEIGHT - (2*PADDLE_H), .w = PADDLE_W, .h = PADDLE_H},
-        .move_speed = WIDTH * 0.6f,
-        .move_left = false,
-        .move_right = false,
-        .colour = grey,
-        .game_started = false,
-        .half_size = false,
-    };
-    
-    game->ball = (Ball) {
-        .shape = (SDL_FRect) {
-            .x = (game->player.shape.x + (0.5f*game->player.shape.w)),
-            .y = (game->player.shape.y - BALL_SIZE),
-            .w = BALL_SIZE, .h = BALL_SIZE
-        },
-        .move_speed = MIN_BALL_SPEED,
-        .speed_modifier = 0.9f,   
-    };
+    if (!input_queue_start(&game->input_queue)) {
+        return false;
+    }
 
-    for (int y = 0; y < BLOCK_COLS; y++) {
-        for (int x = 0; x < BLOCK_ROWS; x++) {
-            game->blocks[y][x].alive = true;
-            game->blocks[y][x].shape = (SDL_FRect) {
-                .x = (0.5f * BLOCK_W_GAP + BLOCK_X_OFFSET) + (x * (float)BLOCK_W),
-                .y = (HOTBAR_H + BLOCK_Y_OFFSET + ((y * BLOCK_H) + (y * BLOCK_Y_OFFSET))),
-                .w = (float)BLOCK_W - BLOCK_X_OFFSET,
-                .h = BLOCK_H
-            };
-            switch (y) {
-                case 0:
-                case 1:
-                    game->blocks[y][x].color = red;
-                    game->blocks[y][x].points = RED_POINTS;
-                    break;
-                case 2:
-                case 3:
-                    game->blocks[y][x].color = pink;
-                    game->blocks[y][x].points = PINK_POINTS;
-                    break;
-                case 4:
-                case 5:
-                    game->blocks[y][x].color = green;
-                    game->blocks[y][x].points = GREEN_POINTS;
-                    break;
-                case 6:
-                case 7:
-                    game->blocks[y][x].color = yellow;
-                    game->blocks[y][x].points = YELLOW_POINTS;
-                    break;
-                default:
-                    break;
-            }
-        }
+    shape_batch_init(&game->shapes);
+    // a fixed seed keeps the sparks in captures of the same replay identical
+    particles_init(&game->particles, 1);
+    profiler_init(&game->profiler);
+    game->show_perf = false;
+    game->perf_text[0] = '\0';
+    game->play_allocs = 0;
+    game->menu_score_text[0] = '\0';
+    if (!save_open(&game->saver, &game->save)) {
+        return false;
     }
+    startup_phase("save");
+    game->hiscore = save_best_score(&game->save);
+    game->hotbar = (SDL_FRect) {.x = 0, .y = 0, .w = WIDTH, .h = HOTBAR_H};
+    game->input = (SimInput) {0};
+    sim_init(&game->world);
+    sim_seed(&game->world, SDL_GetTicksNS());
+    game->prev_paddle = game->world.player.shape;
+    snapshot_ring_init(&game->history, (int)(REWIND_SECONDS * config->tick_rate));
+    game->alpha = 1.0f;
+    game->damaged = true;
     
     for (int i = 0; i < MAX_UITypes; i++) {
         game->ui_elements[i].id = i;
-        populate_ui_textures(i);
+        game->ui_elements[i].text[0] = '\0';
+        game->ui_elements[i].quad_count = 0;
+        populate_ui_text(i);
     }    
 
     return true;
 }
 
 void reset_gamestate(void) {
-    game->time.minutes = 0;
-    game->time.seconds = 0;
-    game->time.previous_time = 0;
-    populate_ui_textures(TIME);
-
-    game->points = 0;
-    populate_ui_textures(POINTS);
-    game->brick_count = BLOCK_COLS * BLOCK_ROWS;
-    game->lives = MAX_LIVES;
-    populate_ui_textures(LIVES);
-    game->player.half_size = false;
-    game->player.shape = (SDL_FRect) {.x = (WIDTH * 0.5f) - (PADDLE_W * 0.5f), .y = HEIGHT - (2*PADDLE_H), .w = PADDLE_W, .h = PADDLE_H};
-    game->player.colour = white;
-
-    for (Block* b = &game->blocks[0][0]; b < &game->blocks[0][0] + (BLOCK_ROWS * BLOCK_COLS); b++) {
-        b->alive = true;
-    }
-    
+    sim_reset(&game->world);
+    populate_ui_text(TIME);
+    populate_ui_text(POINTS);
+    populate_ui_text(LIVES);
 }
 
 void free_gamestate() {
@@ -362,367 +295,578 @@ void free_gamestate() {
         return;
     }
 
+    save_close(&game->saver);
+    glyph_atlas_destroy(&game->atlas);
+    render_scaler_destroy(&game->scaler);
+    if (game->capturing) capture_close(&game->capture);
+    input_queue_stop(&game->input_queue);
+    if (game->versus_on) net_close(&game->link);
     SDL_DestroyRenderer(game->renderer);
     game->renderer = NULL;
-    SDL_DestroyWindow(game->window);
+    if (game->window) SDL_DestroyWindow(game->window);
     game->window = NULL;
-    TTF_DestroyRendererTextEngine(game->text_engine);
-    game->text_engine = NULL;
-    TTF_DestroyText(game->menu_text);
-    game->menu_text = NULL;
-    TTF_DestroyText(game->menu_score_text);
-    game->menu_score_text = NULL;
-    
-    for (int i = 0; i < MAX_UITypes; i++) {
-        if (game->ui_elements[i].texture != NULL) {
-            SDL_DestroyTexture(game->ui_elements[i].texture);
-            game->ui_elements[i].texture = NULL;
-        }
-    }
+    if (game->canvas) SDL_DestroySurface(game->canvas);
+    game->canvas = NULL;
     
-    free(game);
+    arena_reset(&session);
     game = NULL;
 }
 
-bool get_collision(SDL_FRect a, SDL_FRect b) {
-
-    if (a.x < b.x + b.w && a.x + a.w > b.x && a.y < b.y + b.h && a.y + a.h > b.y) {
-        return true;
-    }
-
-    return false;
+SDL_FRect to_frect(SimRect r) {
+    return (SDL_FRect) {.x = r.x, .y = r.y, .w = r.w, .h = r.h};
 }
 
-void set_previous_score(void) {
-    char buffer[50];
-    sprintf(buffer, "previous score: %d\n", game->points);
-    if (game->menu_score_text == NULL) {
-        game->menu_score_text =  TTF_CreateText(game->text_engine, game->font, buffer, 0);
-    } else {
-      bool succ =  TTF_SetTextString(game->menu_score_text, buffer, 0);
-      if (!succ) {
-          printf("Error_set_prev_score: %s", SDL_GetError());
-      }
-    }
+// position between the last two ticks, so motion stays smooth when frames and ticks don't line up
+SDL_FRect lerp_frect(SimRect prev, SimRect cur, float alpha) {
+    return (SDL_FRect) {
+        .x = prev.x + (cur.x - prev.x) * alpha,
+        .y = prev.y + (cur.y - prev.y) * alpha,
+        .w = cur.w,
+        .h = cur.h
+    };
 }
 
-void update_game(double dt) {
-    
-    bool life_update = false;
-    bool score_update = false;
+void set_previous_score(int score) {
+    snprintf(game->menu_score_text, sizeof(game->menu_score_text), "previous score: %d", score);
+}
 
-    {
-        //::update timer
-        if (game->status != IN_MENU  && game->player.game_started) {
-            time_t current_time = SDL_GetTicks();
-        
-            if (current_time - game->time.previous_time >= 1000) {
-                game->time.seconds += 1;
-                if (game->time.seconds >= 60) {
-                    game->time.seconds = 0;
-                    game->time.minutes += 1;
-                }
-            
-                populate_ui_textures(TIME);
-                game->time.previous_time = current_time;
-            }    
+// a burst tinted like the brick for every brick the last tick broke
+void emit_brick_sparks(const uint64_t* alive_before) {
+    const BrickField* f = &game->world.bricks;
+    for (int r = 0; r < f->rows; r++) {
+        uint64_t gone = alive_before[r] & ~f->row_alive[r];
+        for (int c = 0; gone != 0 && c < f->cols; c++) {
+            if (!((gone >> c) & 1u)) continue;
+            int i = r * f->cols + c;
+            SimRect brick = {.x = f->x[i], .y = f->y[i], .w = f->w[i], .h = f->h[i]};
+            particles_burst(&game->particles, brick, f->color[i], BRICK_SPARKS, 220.0f, 0.8f);
         }
     }
+}
 
-    {
-        //::update ball
-        float new_x = 0.0f;
-        float new_y = 0.0f;
-
-        if (game->consecutive_hits == 0 || game->status == RESET_ROUND) {
-            game->ball.speed_modifier = 0.9f;
-        }
-
-        if (game->first_hit_pink_or_red) {
-            game->ball.move_speed = MIN_BALL_SPEED + 50;
-        }
-
-        if (game->consecutive_hits == 4 || game->consecutive_hits == 13) {   
-            game->consecutive_hits += 1;
-            game->ball.speed_modifier = game->ball.speed_modifier + 0.25f;
-        }
-    
-        if (game->status == RESET_ROUND) {
-            game->first_hit_top_wall = false;
-            game->first_hit_pink_or_red = false;
-            game->consecutive_hits = 0;
-            game->ball.shape.x = game->player.shape.x + (0.5f*game->player.shape.w);
-            game->ball.shape.y = game->player.shape.y - BALL_SIZE;
-            game->ball.vel_y = -1.0f;
-            game->ball.vel_x = 0.0f;
-            game->ball.move_speed = MIN_BALL_SPEED;
-        } else {
-            if (game->ball.vel_x == 0.0f || game->ball.vel_x == -0.0f) game->ball.vel_x = 0.003f;
-        
-            float dynamic_move_x = game->ball.speed_modifier * (game->ball.move_speed + ((1.0f - SDL_fabsf(game->ball.vel_x)) * game->ball.move_speed));
-            float dynamic_move_y = game->ball.speed_modifier * (game->ball.move_speed * (1.0f + (1.0f - SDL_fabs(game->ball.vel_x))));
-         
-            new_x = (game->ball.vel_x * dynamic_move_x * dt);
-            new_y = (game->ball.vel_y * dynamic_move_y * dt);
-            Ball collider = game->ball;
-            collider.shape.x += new_x;
-            collider.shape.y += new_y;
-            
-            if (collider.shape.x <= 0 || collider.shape.x + BALL_SIZE > WIDTH) {
-                collider.vel_x *= -1;
-                goto exit_collision;
-            }
-        
-            if (collider.shape.y <= HOTBAR_H) {
-                game->first_hit_top_wall = true;
-                collider.vel_y *= -1;      
-                goto exit_collision;
-            }
+// sparks off the paddle's top edge under every ball that just bounced off it
+void emit_paddle_sparks(void) {
+    const SimRect* paddle = &game->world.player.shape;
+    for (int i = 0; i < game->world.ball_count; i++) {
+        const Ball* b = &game->world.balls[i];
+        if (b->vel_y >= 0.0f || b->shape.y + b->shape.h < paddle->y - BALL_SIZE) continue;
+        SimRect at = {.x = b->shape.x, .y = paddle->y - 2.0f, .w = b->shape.w, .h = 2.0f};
+        particles_burst(&game->particles, at, game->world.player.colour, PADDLE_SPARKS, 160.0f, 0.4f);
+    }
+}
 
-            if (collider.shape.y > game->player.shape.y + (0.5* game->player.shape.h)) {
-                game->lives -=1;
-                life_update = true;
-                game->status = RESET_ROUND;
-                goto exit_collision;
-            }
-        
-            if (get_collision(collider.shape, game->player.shape)) {
-                float mid_collider = collider.shape.x + (0.5f * collider.shape.w);
-                float mid_paddle = game->player.shape.x + (0.5f * game->player.shape.w);
-                float end_paddle = game->player.shape.x + game->player.shape.w;
-                float half_paddle_size = PADDLE_W * 0.5f;
-
-                if (mid_collider > mid_paddle) {
-                    float relative_pos = half_paddle_size  - (end_paddle - mid_collider);
-                    collider.vel_x = relative_pos / 100.0f;
-                } else if (collider.shape.x < game->player.shape.x + (0.5f * game->player.shape.w)) {
-                    float relative_pos = half_paddle_size - (mid_collider - game->player.shape.x);
-                    collider.vel_x = -1 * (relative_pos / 100.0f);
-                } 
-                collider.vel_y = -1;
-                goto exit_collision;
-            }
+bool update_game(double dt) {
+    if (game->replay_mode == REPLAY_PLAYBACK && !replay_play_tick(&game->replay, &game->input)) {
+        return false;
+    }
+    if (game->replay_mode == REPLAY_RECORDING) {
+        replay_record_tick(&game->replay, &game->input);
+    }
 
-            for (Block *b = &game->blocks[0][0]; b < &game->blocks[0][0] + (BLOCK_ROWS * BLOCK_COLS); b++) {
-                if (b->alive) {
-                    if (get_collision(collider.shape, b->shape)) {
-                        collider.vel_x = (collider.vel_x >= 0.0f) ? BLOCK_COLLISION_ANGLE : -BLOCK_COLLISION_ANGLE;
-                        collider.vel_y *= -1;
-                        game->consecutive_hits += 1;
-                        if ((b->points == PINK_POINTS || b->points == RED_POINTS) && !game->first_hit_pink_or_red) {
-                            game->first_hit_pink_or_red = true;
-                        }
-                        b->alive = false;
-                        game->brick_count -=1;
-                        game->points += b->points;
-                        score_update = true;
-                        goto exit_collision;
-                                            
-                    }    
-                }
-            }
-            exit_collision:           
-            game->ball = collider; 
-        }
-    
+    game->prev_paddle = game->world.player.shape;
+    uint64_t alive_before[BRICK_MAX_ROWS];
+    memcpy(alive_before, game->world.bricks.row_alive, sizeof(alive_before));
+    uint32_t events = game->versus_on ? versus_step(&game->versus, &game->input) : sim_step(&game->world, &game->input, dt);
+    if (events & (SIM_EVENT_LIFE_LOST | SIM_EVENT_GAME_OVER)) {
+        // the ball teleports back to the paddle, don't smear it across the screen
+        for (int i = 0; i < game->world.ball_count; i++) game->world.balls[i].prev = game->world.balls[i].shape;
+        game->prev_paddle = game->world.player.shape;
     }
-    
-    { 
-        //::update player
-        if (game->first_hit_top_wall && !game->player.half_size) {
-            game->player.half_size = true;
-            game->player.shape.w *= 0.5f;
-            game->player.shape.x += 0.5f * PADDLE_W;
-        } 
-        if (game->player.move_left && !game->player.move_right) game->player.velocity = -1;
-        else if (game->player.move_right && !game->player.move_left) game->player.velocity = 1;
-        else game->player.velocity = 0;
-        
-        float new_x = game->player.shape.x + (game->player.velocity * game->player.move_speed * dt);
-        if (new_x < 0 || new_x + game->player.shape.w > WIDTH) new_x = game->player.shape.x;
-        game->player.shape.x = new_x;     
+    game->input.serve = false;
+    game->input.menu_yes = false;
+    game->input.menu_no = false;
+    if (events) game->damaged = true;
+    if (events & SIM_EVENT_SCORE) emit_brick_sparks(alive_before);
+    if (events & SIM_EVENT_PADDLE) emit_paddle_sparks();
+
+    profiler_begin(&game->profiler, PROF_UI);
+    if (events & SIM_EVENT_GAME_OVER) {
+        // the finished game is already in the save, it can't be rewound into
+        snapshot_ring_clear(&game->history);
+        if (game->replay_mode != REPLAY_PLAYBACK) record_game();
+        set_previous_score(game->world.last_score);
+        populate_ui_text(TIME);
+        populate_ui_text(POINTS);
+        populate_ui_text(LIVES);
+    } else {
+        if (events & SIM_EVENT_TIME) populate_ui_text(TIME);
+        if (events & SIM_EVENT_LIFE_LOST) populate_ui_text(LIVES);
+        if (events & SIM_EVENT_SCORE) populate_ui_text(POINTS);
     }
+    profiler_end(&game->profiler, PROF_UI);
 
-    //::update state
+    return !(events & SIM_EVENT_QUIT);
+}
 
-    if (life_update) populate_ui_textures(LIVES);
-    if (score_update) populate_ui_textures(POINTS);
+// one tick back in time while R is held; a replay's log only runs forwards, so not while one is open
+void rewind_game(void) {
+    if (!snapshot_ring_rewind(&game->history, &game->world, 1)) return;
+    game->prev_paddle = game->world.player.shape;
+    game->input.serve = false;
+    game->input.menu_yes = false;
+    game->input.menu_no = false;
+    populate_ui_text(TIME);
+    populate_ui_text(POINTS);
+    populate_ui_text(LIVES);
+}
 
-    if (game->brick_count <= 0) {
-        game->player.colour = green;
-        update_hiscore();
-        set_previous_score();
-        reset_gamestate();
-        game->status = IN_MENU;
-    } else if (game->lives <= 0) {
-        game->player.colour = red;
-        update_hiscore();
-        set_previous_score();
-        reset_gamestate();
-        game->status = IN_MENU;
-    }
+// true when ticking on changes nothing on screen: the menu, or a round waiting for its serve with
+// no paddle key held. The loop then draws only damaged frames and sleeps on the event queue
+bool scene_idle(void) {
+    if (game->capturing || game->versus_on || game->rewinding || game->replay_mode == REPLAY_PLAYBACK) return false;
+    if (!input_queue_empty(&game->input_queue) || game->particles.count > 0) return false;
+    if (game->world.status == IN_MENU) return true;
+    return game->world.status == RESET_ROUND && !game->input.move_left && !game->input.move_right;
 }
 
-void make_menu_text(void) {
-    char menu_buffer[50];
-    sprintf(menu_buffer, "20g_breakout\nplay: y/n");
-    game->menu_text = TTF_CreateText(game->text_engine, game->font, menu_buffer, 0);
+// an idle frame sleeps until an event, or until the in-game clock would tick over to the next
+// second while a started game waits for its serve
+int idle_timeout_ms(double accumulator, double time_scale) {
+    const SimWorld* w = &game->world;
+    if (w->status != RESET_ROUND || !w->player.game_started) return IDLE_WAKE_MS;
+    double sim_left = 1.0 - w->time.elapsed - accumulator;
+    if (sim_left <= 0.0) return 0;
+    return SDL_min(IDLE_WAKE_MS, (int)SDL_ceil(sim_left / time_scale * 1000.0));
 }
 
 void draw_game() {
     SDL_SetRenderDrawBlendMode(game->renderer, SDL_BLENDMODE_NONE);
     SDL_SetRenderDrawColor(game->renderer, off_black.r, off_black.g, off_black.b, off_black.a);
-    SDL_RenderClear(game->renderer);
+    // fill rather than clear: a scaled frame only covers the top left of its target
+    SDL_RenderFillRect(game->renderer, &(SDL_FRect) {.x = 0, .y = 0, .w = WIDTH, .h = HEIGHT});
+    int draw_calls = 1;
 
     //::draw ui
-    for (int i = 0; i < MAX_UITypes; i++) {
-        if (game->ui_elements[i].texture != NULL && i != MENU) {
-            SDL_FRect dest;
-            SDL_GetTextureSize(game->ui_elements[i].texture, &dest.w, &dest.h);
-            float remaining_h = HOTBAR_H - dest.h;
-            dest.y = game->ui_elements[i].y + (0.5f * remaining_h);
-            dest.x = game->ui_elements[i].x + (0.5f * BLOCK_W_GAP + BLOCK_X_OFFSET);
-            SDL_RenderTexture(game->renderer, game->ui_elements[i].texture, NULL, &dest);
-        }
+    if (game->show_perf) {
+        float w, h;
+        text_measure(&game->atlas, FONT_SMALL, game->perf_text, &w, &h);
+        text_queue(&game->atlas, FONT_SMALL, game->perf_text, 0.5f * BLOCK_W_GAP + BLOCK_X_OFFSET, 0.5f * (HOTBAR_H - h), white);
+    }
+    for (int i = 0; i < MAX_UITypes && !game->show_perf; i++) {
+        if (i != MENU) text_queue_quads(&game->atlas, game->ui_elements[i].quads, game->ui_elements[i].quad_count);
     }
 
     //::draw grid
-    for (Block *b = &game->blocks[0][0]; b < &game->blocks[0][0] + (BLOCK_COLS * BLOCK_ROWS); b++) {
-        if (b->alive) {
-            SDL_SetRenderDrawColor(game->renderer, b->color.r, b->color.g, b->color.b, b->color.a);
-            SDL_RenderFillRect(game->renderer, &b->shape);
-        }
-    }    
-    //::draw ball
-    SDL_SetRenderDrawColor(game->renderer, white.r, white.g, white.b, white.a);
-    SDL_RenderFillRect(game->renderer, &game->ball.shape);
-
-    //::draw player
-    Player p = game->player;
-    SDL_SetRenderDrawColor(game->renderer, p.colour.r, p.colour.g, p.colour.b, p.colour.a);
-    SDL_RenderFillRect(game->renderer, &p.shape);
+    shape_batch_update_bricks(&game->shapes, &game->world);
+
+    //::draw hotbar, ball, player
+    Player p = game->world.player;
+    SDL_Color paddle_colour = {p.colour.r, p.colour.g, p.colour.b, p.colour.a};
+    shape_batch_add(&game->shapes, game->hotbar, off_black);
+    for (int i = 0; i < game->world.ball_count; i++) {
+        const Ball* ball = &game->world.balls[i];
+        shape_batch_add(&game->shapes, lerp_frect(ball->prev, ball->shape, game->alpha), white);
+    }
+    shape_batch_add(&game->shapes, lerp_frect(game->prev_paddle, p.shape, game->alpha), paddle_colour);
+    draw_calls += shape_batch_flush(&game->shapes, game->renderer);
+    particles_build(&game->particles);
+    draw_calls += particles_flush(&game->particles, game->renderer);
 
     //::draw menu
-    if (game->status == IN_MENU) {
+    if (game->world.status == IN_MENU) {
         if (!SDL_SetRenderDrawBlendMode(game->renderer, SDL_BLENDMODE_BLEND_PREMULTIPLIED)) {
                 printf("Error_blend: %s\n", SDL_GetError());
         }
         SDL_SetRenderDrawColor(game->renderer, black.r, black.g, black.b, 128);
         SDL_FRect dest = (SDL_FRect) {.x = WIDTH * 0.2f, .y = HEIGHT * 0.1f, .w = WIDTH * 0.6f, .h = HEIGHT * 0.6f};
         SDL_RenderFillRect(game->renderer, &dest);
+        draw_calls += 1;
         
-        TTF_SetFontSize(game->font, 36);
-        TTF_DrawRendererText(game->menu_text, dest.x + 20, dest.y + 15);
-        if (game->player.game_started && game->menu_score_text != NULL) {
-            TTF_DrawRendererText(game->menu_score_text, dest.x + 20, dest.h - 15);
+        const char* title = game->versus_on && !game->versus.connected ? "20g_breakout\nwaiting for rival" : "20g_breakout\nplay: y/n";
+        text_queue(&game->atlas, FONT_LARGE, title, dest.x + 20, dest.y + 15, white);
+        if (game->world.player.game_started && game->menu_score_text[0] != '\0') {
+            text_queue(&game->atlas, FONT_LARGE, game->menu_score_text, dest.x + 20, dest.h - 15, white);
             
         }
                 
     }
-       
-    
-    SDL_RenderPresent(game->renderer);
+
+    //::draw text
+    draw_calls += text_flush(&game->atlas, game->renderer);
+
+    profiler_count_draws(&game->profiler, draw_calls);
+}
+
+// SDL grows its command and vertex buffers to the largest frame queued so far, so draw one frame
+// with every spark slot, shape and glyph quad in use before play instead of on the first big burst
+void warm_renderer(void) {
+    ParticleSystem* p = &game->particles;
+    uint64_t rng = p->rng;
+    particles_burst(p, (SimRect) {0, 0, WIDTH, HEIGHT}, (SimColor) {0, 0, 0, 0}, PARTICLE_CAPACITY, 0.0f, 1.0f);
+    SDL_Vertex blank[4] = {0};
+    for (int i = 0; i < MAX_TEXT_QUADS; i++) text_queue_quads(&game->atlas, blank, 1);
+
+    SDL_SetRenderTarget(game->renderer, game->scaler.target);
+    draw_game();
+    while (game->shapes.quad_count < BATCH_MAX_QUADS) shape_batch_add(&game->shapes, (SDL_FRect) {0}, off_black);
+    shape_batch_flush(&game->shapes, game->renderer);
+    SDL_FlushRenderer(game->renderer);
+    SDL_SetRenderTarget(game->renderer, NULL);
+
+    particles_clear(p);
+    p->rng = rng;
+    game->damaged = true;
+}
+
+void update_perf_text(void) {
+    ProfStats stats;
+    profiler_stats(&game->profiler, &stats);
+    snprintf(game->perf_text, sizeof(game->perf_text), "p50 %.2fms p99 %.2fms ticks %.2f draws %.0f x%.2f allocs %u",
+             stats.frame_p50_ms, stats.frame_p99_ms, stats.ticks_per_frame, stats.draw_calls, game->scaler.scale,
+             game->play_allocs);
+    if (stats.dropped_spans > 0) {
+        size_t len = strlen(game->perf_text);
+        snprintf(game->perf_text + len, sizeof(game->perf_text) - len, " lost spans %d", stats.dropped_spans);
+    }
+    if (game->versus_on) {
+        const VersusStats* v = &game->versus.stats;
+        snprintf(game->perf_text, sizeof(game->perf_text), "p99 %.2fms rtt %.0fms rollback %d (max %d) stalls %llu",
+                 stats.frame_p99_ms, v->rtt_ms, v->rollback_depth, v->max_rollback_depth, (unsigned long long)v->stalls);
+    }
+}
+
+// peer is "host" or "host:port"; a missing port means the rival listens on the same one we do
+bool start_versus(const char* peer, int port, int delay) {
+    if (peer == NULL) return true;
+    char host[256];
+    int peer_port = port;
+    const char* colon = strrchr(peer, ':');
+    size_t host_len = colon ? (size_t)(colon - peer) : strlen(peer);
+    if (host_len == 0 || host_len >= sizeof(host)) {
+        printf("Error - --versus takes host or host:port, not %s\n", peer);
+        return false;
+    }
+    memcpy(host, peer, host_len);
+    host[host_len] = '\0';
+    if (colon) peer_port = atoi(colon + 1);
+
+    if (!net_udp_open(&game->link, port, host, peer_port)) return false;
+    uint64_t seed = SDL_GetPerformanceCounter() ^ SDL_GetTicksNS();
+    versus_start(&game->versus, &game->link, &game->world, (uint32_t)game->config.tick_rate, delay, seed);
+    game->versus_on = true;
+    populate_ui_text(HIGH_SCORE);
+    printf("versus: waiting for %s:%d on port %d\n", host, peer_port, port);
+    return true;
+}
+
+void finish_versus(void) {
+    if (game == NULL || !game->versus_on) return;
+    const VersusStats* v = &game->versus.stats;
+    printf("versus: %u ticks, rtt %.1fms, %llu rollbacks (max depth %d), %llu ticks resimulated in %.2fms, "
+           "%llu stalls, %llu/%llu packets, %llu sync checks%s\n",
+           game->versus.tick, v->rtt_ms, (unsigned long long)v->rollbacks, v->max_rollback_depth,
+           (unsigned long long)v->resim_ticks, v->resim_ns / 1e6, (unsigned long long)v->stalls,
+           (unsigned long long)v->packets_sent, (unsigned long long)v->packets_received,
+           (unsigned long long)v->sync_checks, v->desync_tick ? ", DESYNCED" : "");
+}
+
+bool start_replay(const char* record_path, const char* replay_path) {
+    if (replay_path != NULL) {
+        if (!replay_play_open(&game->replay, replay_path)) return false;
+        if (game->replay.tick_rate < 10 || game->replay.tick_rate > 1000) {
+            printf("Error - replay recorded at an unsupported %u Hz\n", game->replay.tick_rate);
+            replay_play_close(&game->replay);
+            return false;
+        }
+        if ((int)game->replay.tick_rate != game->config.tick_rate) {
+            // inputs were logged per tick, so the replay only reproduces at its own rate
+            printf("replay recorded at %u Hz, stepping at that rate\n", game->replay.tick_rate);
+            game->config.tick_rate = (int)game->replay.tick_rate;
+        }
+        if (game->replay.level_hash != game->world.bricks.level_hash) {
+            printf("Error - replay was recorded on a different level\n");
+            replay_play_close(&game->replay);
+            return false;
+        }
+        sim_seed(&game->world, game->replay.seed);
+        game->replay_mode = REPLAY_PLAYBACK;
+    } else if (record_path != NULL) {
+        uint64_t seed = SDL_GetTicksNS();
+        sim_seed(&game->world, seed);
+        if (!replay_record_open(&game->replay, record_path, (uint32_t)game->config.tick_rate, seed, game->world.bricks.level_hash)) return false;
+        game->replay_mode = REPLAY_RECORDING;
+    }
+    return true;
+}
+
+void finish_replay(void) {
+    uint64_t checksum = sim_checksum(&game->world);
+    if (game->replay_mode == REPLAY_RECORDING) {
+        replay_record_close(&game->replay, checksum);
+    } else if (game->replay_mode == REPLAY_PLAYBACK) {
+        if (!game->replay.finished) {
+            printf("replay stopped after %llu ticks\n", (unsigned long long)game->replay.ticks);
+        } else {
+            bool match = checksum == game->replay.checksum;
+            printf("replay %s after %llu ticks\n", match ? "matches" : "DIVERGED", (unsigned long long)game->replay.ticks);
+        }
+        replay_play_close(&game->replay);
+    }
+    game->replay_mode = REPLAY_OFF;
 }
 
 int main(int argc, char* argv[]) {
-    (void)argc; (void)argv;
+    const char* record_path = NULL;
+    const char* replay_path = NULL;
+    const char* profile_path = NULL;
+    const char* level_path = NULL;
+    int level_index = 0;
+    const char* capture_path = NULL;
+    int capture_fps = 60;
+    const char* versus_peer = NULL;
+    int versus_port = VERSUS_PORT;
+    int versus_delay = VERSUS_DELAY;
+    int spark_flood = 0;
+    GameConfig config;
+    config_defaults(&config);
+    const char* config_path = NULL;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--config") == 0) config_path = argv[i + 1];
+    }
+    if (!config_load(&config, config_path ? config_path : CONFIG_FILE, config_path != NULL)) return -1;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--record") == 0) {
+            record_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--replay") == 0) {
+            replay_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profile_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--level") == 0) {
+            level_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--level-index") == 0) {
+            level_index = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--capture") == 0) {
+            capture_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--capture-fps") == 0) {
+            capture_fps = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--versus") == 0) {
+            versus_peer = argv[i + 1];
+        } else if (strcmp(argv[i], "--port") == 0) {
+            versus_port = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--input-delay") == 0) {
+            versus_delay = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--spark-flood") == 0) {
+            spark_flood = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--config") == 0) {
+            continue;
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            if (!config_set(&config, argv[i] + 2, argv[i + 1])) return -1;
+        }
+    }
 
-    if (!SDL_Init(SDL_INIT_VIDEO)) {
-        printf("Error_init: %s\n", SDL_GetError());
+    if (capture_path != NULL && (replay_path == NULL || capture_fps < 1 || capture_fps > 1000)) {
+        printf("Error - --capture renders a --replay offscreen, at --capture-fps 1..1000\n");
+        return -1;
+    }
+    if (spark_flood < 0 || spark_flood > PARTICLE_CAPACITY) {
+        printf("Error - --spark-flood keeps 0..%d sparks alive\n", PARTICLE_CAPACITY);
+        return -1;
+    }
+    if (versus_peer != NULL && (record_path || replay_path || capture_path || versus_port < 1 || versus_port > 65535)) {
+        printf("Error - --versus can't be combined with --record, --replay or --capture, --port takes 1..65535\n");
         return -1;
     }
 
-    
-    if (!TTF_Init()) {
-        printf("Error_ttf_init: %s\n", SDL_GetError());
+    // must come before SDL makes its first allocation
+    alloc_count_install();
+    startup_start = startup_last = SDL_GetTicksNS();
+
+    // capturing draws with the software renderer into a surface, no display needed
+    if (!SDL_Init(capture_path ? 0 : SDL_INIT_VIDEO)) {
+        printf("Error_init: %s\n", SDL_GetError());
         return -1;
     }
+    startup_phase("init");
 
     bool running = false;
-    if (gamestate_create()) {
+    if (gamestate_create(&config, capture_path != NULL)
+        && (level_path == NULL || level_load(&game->world, level_path, level_index))
+        && start_replay(record_path, replay_path)
+        && start_versus(versus_peer, versus_port, versus_delay)
+        && (capture_path == NULL || capture_open(&game->capture, game->renderer, capture_path, WIDTH, HEIGHT, capture_fps))) {
+        game->capturing = capture_path != NULL;
         running = true;
     }
 
-    make_menu_text();
-    
     SDL_Event e;
-        
-    uint64_t current_time = SDL_GetPerformanceCounter();
+    if (running) {
+        // a capture runs as fast as frames can be drawn and written, each one covering 1/capture_fps
+        pacer_init(&game->pacer, game->renderer, game->capturing ? PACE_UNCAPPED : game->config.pacing, game->config.fps);
+        warm_renderer();
+        startup_phase("setup");
+    }
+    bool first_frame = true;
+
+    // the sim always steps by sim_dt of simulated time; time_scale only changes how much of it
+    // each real second feeds the accumulator, so the in-game clock keeps counting sim seconds
+    double sim_dt = running ? 1.0 / game->config.tick_rate : 1.0;
+    double time_scale = running ? game->config.time_scale : 1.0;
+    int max_steps = running ? (int)SDL_ceil(MAX_CATCHUP_S * time_scale / sim_dt) : 1;
+    // a captured frame always covers 1/capture_fps of sim time, however long it took to draw, so
+    // it must step all of it or a low --capture-fps video drifts behind the replay
+    if (running && game->capturing) max_steps = (int)SDL_ceil(time_scale / (capture_fps * sim_dt)) + 1;
+    int perf_every = running ? SDL_max(1, game->config.fps / 4) : 1;
+
+    uint64_t current_time = SDL_GetTicksNS();
     uint64_t last_time = 0;
     double delta_time = 0.0f;
-
-    game->status = IN_MENU;
+    bool woke_from_idle = false;
     
     while (running) {
         last_time = current_time;
-        current_time = SDL_GetPerformanceCounter();
-        delta_time = (double)((current_time - last_time) * 1000) / SDL_GetPerformanceFrequency();           
+        current_time = SDL_GetTicksNS();
+        delta_time = (double)(current_time - last_time) / SDL_NS_PER_SECOND;
+        if (game->capturing) delta_time = 1.0 / capture_fps;
+        profiler_frame_begin(&game->profiler);
+        uint32_t frame_allocs = alloc_count();
+        bool resized = false;
+        bool was_playing = game->world.status == IN_PLAY;
         
-       
+        profiler_begin(&game->profiler, PROF_EVENTS);
         while (SDL_PollEvent(&e)) {
             if (e.type == SDL_EVENT_QUIT) {
                 running = false;
                 break;
             }
-            if (e.type == SDL_EVENT_KEY_DOWN && game->status != IN_MENU) {
-                switch (e.key.key) {
-                    case SDLK_A:
-                    case SDLK_LEFT:
-                        game->player.move_left = true;
-                        break;
-                    case SDLK_D:
-                    case SDLK_RIGHT:
-                        game->player.move_right = true;
-                        break;
-                    case SDLK_SPACE:
-                        if (game->status == RESET_ROUND) {
-                            game->status = IN_PLAY;
-                            game->player.game_started = true;
-                        }
-                        break;
-                    default:
-                        break;
-                }
+            if (e.type == SDL_EVENT_KEY_DOWN && e.key.key == SDLK_F3 && !e.key.repeat) {
+                game->show_perf = !game->show_perf;
+                update_perf_text();
+                game->damaged = true;
             }
-            if (e.type == SDL_EVENT_KEY_DOWN && game->status == IN_MENU) {
-                if (e.key.key == SDLK_Y) {
-                    game->status = RESET_ROUND;
-                } else if (e.key.key == SDLK_N) {
-                    running = false;
-                }
+            if (e.type >= SDL_EVENT_WINDOW_FIRST && e.type <= SDL_EVENT_WINDOW_LAST) {
+                // exposed, resized, restored...: the window contents may be gone
+                game->damaged = true;
             }
-            if (e.type == SDL_EVENT_KEY_UP && game->status != IN_MENU) {
-                switch (e.key.key) {
-                    case SDLK_A:
-                    case SDLK_LEFT:
-                        game->player.move_left = false;
-                        break;
-                    case SDLK_D:
-                    case SDLK_RIGHT:
-                        game->player.move_right = false;
-                        break;
-                    default:
-                        break;
-                }
+            if (e.type == SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED && !game->capturing) {
+                if (!render_scaler_resize(&game->scaler, game->renderer)) running = false;
+                resized = true;
             }
+            if ((e.type == SDL_EVENT_KEY_DOWN || e.type == SDL_EVENT_KEY_UP) && e.key.key == SDLK_R) {
+                game->rewinding = e.type == SDL_EVENT_KEY_DOWN;
+            }
+            // game keys reach the sim through game->input_queue, see input.h
+        }
+        profiler_end(&game->profiler, PROF_EVENTS);
+
+        if (game->versus_on) {
+            uint64_t poll_start = SDL_GetTicksNS();
+            uint64_t resim_ticks = game->versus.stats.resim_ticks;
+            if (!versus_poll(&game->versus, poll_start)) running = false;
+            if (game->versus.stats.resim_ticks != resim_ticks) game->versus.stats.resim_ns += SDL_GetTicksNS() - poll_start;
         }
 
         static double accumulator = 0.0f;
-        accumulator += delta_time / 1000.0f;
-        while (accumulator >= TARGET_DT) {
-            if (game->status != IN_MENU) update_game(TARGET_DT);
-            accumulator -= TARGET_DT;
+        SimInput ignored_input = {0};
+        accumulator += delta_time * time_scale;
+        int steps = 0;
+        // after an idle sleep the whole backlog is stepped, the ticks are cheap and the clock stays exact
+        int frame_max_steps = woke_from_idle ? INT32_MAX : max_steps;
+        woke_from_idle = false;
+        while (running && accumulator >= sim_dt && steps < frame_max_steps) {
+            if (game->versus_on && !versus_ready(&game->versus)) {
+                // lockstep wait: the rival is too far behind to keep predicting it
+                game->versus.stats.stalls += 1;
+                break;
+            }
+            profiler_begin(&game->profiler, PROF_UPDATE);
+            // real time this tick's slice of simulated time ends at; keys up to then belong to it
+            uint64_t tick_end = current_time - (uint64_t)((accumulator - sim_dt) / time_scale * SDL_NS_PER_SECOND);
+            input_queue_apply(&game->input_queue, tick_end, game->replay_mode == REPLAY_PLAYBACK ? &ignored_input : &game->input);
+            // both boards of a versus match only move forwards, versus.c rolls back the rival's itself
+            bool can_rewind = game->replay_mode == REPLAY_OFF && !game->versus_on;
+            if (game->rewinding && can_rewind) {
+                rewind_game();
+            } else {
+                if (can_rewind) snapshot_ring_push(&game->history, &game->world);
+                running = update_game(sim_dt);
+            }
+            profiler_end(&game->profiler, PROF_UPDATE);
+            profiler_count_ticks(&game->profiler, 1);
+            accumulator -= sim_dt;
+            steps++;
+        }
+        if (accumulator >= sim_dt) {
+            // after a stall (e.g. dragging the window) drop the backlog instead of catching up
+            accumulator = SDL_fmod(accumulator, sim_dt);
+        }
+        game->alpha = (float)(accumulator / sim_dt);
+        // cosmetic only, so sparks move on frame time rather than ticks
+        particles_update(&game->particles, (float)(delta_time * time_scale));
+        // a test load, not a look: tops the sparks back up to spark_flood every frame of play, so
+        // the allocation check sees the biggest frames warm_renderer() has to cover
+        if (spark_flood > 0 && game->world.status == IN_PLAY && game->particles.count < spark_flood) {
+            particles_burst(&game->particles, game->world.player.shape, game->world.player.colour,
+                            spark_flood - game->particles.count, 220.0f, 0.8f);
+        }
+        if (game->versus_on) {
+            versus_send(&game->versus, SDL_GetTicksNS());
+            populate_ui_text(HIGH_SCORE);
+        }
+
+        // a static scene is drawn once on the way in and then only when damaged
+        bool idle = running && scene_idle();
+        bool redraw = !idle || game->damaged;
+        game->damaged = !idle;
+
+        profiler_begin(&game->profiler, PROF_DRAW);
+        if (game->capturing) {
+            capture_begin_frame(&game->capture, game->renderer);
+            draw_game();
+        } else if (redraw) {
+            render_scaler_begin(&game->scaler, game->renderer);
+            draw_game();
+            render_scaler_end(&game->scaler, game->renderer);
+        }
+        profiler_end(&game->profiler, PROF_DRAW);
+
+        profiler_begin(&game->profiler, PROF_PRESENT);
+        if (game->capturing) {
+            if (!capture_end_frame(&game->capture, game->renderer)) running = false;
+        } else if (redraw) {
+            SDL_RenderPresent(game->renderer);
+        }
+        profiler_end(&game->profiler, PROF_PRESENT);
+        profiler_frame_end(&game->profiler);
+        if (first_frame && (redraw || game->capturing)) {
+            first_frame = false;
+            startup_phase("first frame");
+            print_startup();
         }
 
-        draw_game();
+        static int perf_frames = 0;
+        if (game->show_perf && ++perf_frames % perf_every == 0) update_perf_text();
 
-        double frame_time = (SDL_GetPerformanceCounter() - current_time) * 1000.0 / SDL_GetPerformanceFrequency();
-        if (frame_time < (1000.0f / TARGET_FPS)) {
-            SDL_Delay((1000.0f / TARGET_FPS) - frame_time);
+        if (idle) {
+            pacer_idle(&game->pacer, idle_timeout_ms(accumulator, time_scale));
+            woke_from_idle = true;
+        } else {
+            pacer_wait(&game->pacer);
+        }
+
+        // a frame spent entirely in play must not touch the heap (capture reads back into fresh
+        // surfaces, a resize reallocates the render target)
+        if (was_playing && game->world.status == IN_PLAY && !game->capturing && !resized) {
+            uint32_t allocs = alloc_count() - frame_allocs;
+            game->play_allocs += allocs;
+#ifndef NDEBUG
+            // `make debug` only, a release cabinet just counts them on the F3 overlay
+            if (allocs != 0) printf("Error_alloc: %u heap allocations in a frame during play\n", allocs);
+            SDL_assert(allocs == 0);
+#endif
         }
 
     }
 
+    finish_replay();
+    finish_versus();
+    if (game != NULL && game->capturing) {
+        uint64_t frames = game->capture.frames;
+        bool ok = capture_close(&game->capture);
+        game->capturing = false;
+        printf("captured %llu frames to %s%s\n", (unsigned long long)frames, capture_path, ok ? "" : " (incomplete)");
+    }
+    if (profile_path != NULL && game != NULL) profiler_dump(&game->profiler, profile_path);
     free_gamestate();
     SDL_Quit();
     return 0;
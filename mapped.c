@@ -0,0 +1,63 @@
+#define _POSIX_C_SOURCE 200809L
+#include "mapped.h"
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool mapped_open(MappedFile* m, const char* path) {
+    memset(m, 0, sizeof(*m));
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (data == NULL) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    m->file = file;
+    m->mapping = mapping;
+    m->data = data;
+    m->size = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+    m->data = data;
+    m->size = (size_t)st.st_size;
+#endif
+    return true;
+}
+
+void mapped_close(MappedFile* m) {
+    if (m->data == NULL) return;
+#ifdef _WIN32
+    UnmapViewOfFile((void*)m->data);
+    CloseHandle(m->mapping);
+    CloseHandle(m->file);
+#else
+    munmap((void*)m->data, m->size);
+#endif
+    m->data = NULL;
+    m->size = 0;
+}
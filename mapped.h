@@ -0,0 +1,22 @@
+#ifndef MAPPED_H
+#define MAPPED_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// a whole file mapped read-only, for formats that are read in place (level packs, the glyph cache)
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+#ifdef _WIN32
+    void* file;
+    void* mapping;
+#endif
+} MappedFile;
+
+// false (without printing) when the file is missing, empty or can't be mapped
+bool mapped_open(MappedFile* m, const char* path);
+void mapped_close(MappedFile* m);
+
+#endif
@@ -0,0 +1,157 @@
+#define _POSIX_C_SOURCE 200809L
+#include "net.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#define close_socket closesocket
+#define INVALID_SOCK ((intptr_t)INVALID_SOCKET)
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#define close_socket close
+#define INVALID_SOCK ((intptr_t)-1)
+#endif
+
+static bool set_nonblocking(intptr_t s) {
+#ifdef _WIN32
+    u_long on = 1;
+    return ioctlsocket((SOCKET)s, FIONBIO, &on) == 0;
+#else
+    int flags = fcntl((int)s, F_GETFL, 0);
+    return flags != -1 && fcntl((int)s, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+static bool would_block(void) {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+bool net_udp_open(NetLink* l, int local_port, const char* peer_host, int peer_port) {
+    memset(l, 0, sizeof(*l));
+    l->kind = NET_UDP;
+    l->socket = INVALID_SOCK;
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        printf("Error_net: winsock did not start\n");
+        return false;
+    }
+    l->wsa_started = true;
+#endif
+
+    char port[16];
+    snprintf(port, sizeof(port), "%d", peer_port);
+    struct addrinfo hints = {.ai_family = AF_INET, .ai_socktype = SOCK_DGRAM};
+    struct addrinfo* peer = NULL;
+    if (getaddrinfo(peer_host, port, &hints, &peer) != 0 || peer == NULL) {
+        printf("Error_net: could not resolve %s\n", peer_host);
+        net_close(l);
+        return false;
+    }
+    memcpy(l->peer_addr, peer->ai_addr, peer->ai_addrlen);
+    l->peer_addr_len = (uint32_t)peer->ai_addrlen;
+    freeaddrinfo(peer);
+
+    l->socket = (intptr_t)socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in local = {.sin_family = AF_INET, .sin_port = htons((uint16_t)local_port)};
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (l->socket == INVALID_SOCK || bind(l->socket, (struct sockaddr*)&local, sizeof(local)) != 0
+        || !set_nonblocking(l->socket)) {
+        printf("Error_net: could not bind udp port %d\n", local_port);
+        net_close(l);
+        return false;
+    }
+    return true;
+}
+
+void net_loopback_pair(NetLink* a, NetLink* b, double latency_ms, double jitter_ms, double loss, uint64_t seed) {
+    memset(a, 0, sizeof(*a));
+    memset(b, 0, sizeof(*b));
+    NetLink* ends[2] = {a, b};
+    for (int i = 0; i < 2; i++) {
+        ends[i]->kind = NET_LOOPBACK;
+        ends[i]->peer = ends[1 - i];
+        ends[i]->latency_ns = (uint64_t)(latency_ms * 1e6);
+        ends[i]->jitter_ns = (uint64_t)(jitter_ms * 1e6);
+        ends[i]->loss_permille = (uint32_t)(loss * 1000.0);
+        ends[i]->rng = (seed ^ (0x9E3779B97F4A7C15ull * (i + 1))) | 1;
+    }
+}
+
+static uint32_t loopback_random(NetLink* l) {
+    l->rng ^= l->rng << 13;
+    l->rng ^= l->rng >> 7;
+    l->rng ^= l->rng << 17;
+    return (uint32_t)(l->rng >> 32);
+}
+
+bool net_send(NetLink* l, const void* data, int size, uint64_t now_ns) {
+    if (size <= 0 || size > NET_MAX_PACKET) return false;
+    if (l->kind == NET_UDP) {
+        long sent = (long)sendto(l->socket, data, size, 0, (const struct sockaddr*)l->peer_addr, l->peer_addr_len);
+        // a full send buffer is a dropped datagram, the protocol already resends
+        return sent == size || (sent < 0 && would_block());
+    }
+
+    // jitter is drawn per packet, so like real UDP later packets can overtake earlier ones
+    NetLink* to = l->peer;
+    if (loopback_random(l) % 1000 < l->loss_permille) return true;
+    if (to->queue_count == NET_LOOPBACK_QUEUE) return true;
+    uint64_t jitter = l->jitter_ns ? loopback_random(l) % l->jitter_ns : 0;
+    NetPacket* p = &to->queue[to->queue_count++];
+    p->deliver_at = now_ns + l->latency_ns + jitter;
+    p->size = (uint16_t)size;
+    memcpy(p->data, data, (size_t)size);
+    return true;
+}
+
+int net_recv(NetLink* l, void* buffer, int capacity, uint64_t now_ns) {
+    if (l->kind == NET_UDP) {
+        // only the peer we were pointed at may feed this link, anything else on the port is read
+        // and thrown away so it can't inject inputs
+        struct sockaddr_in peer;
+        memcpy(&peer, l->peer_addr, sizeof(peer));
+        for (;;) {
+            struct sockaddr_in from;
+            socklen_t from_len = sizeof(from);
+            long got = (long)recvfrom(l->socket, buffer, capacity, 0, (struct sockaddr*)&from, &from_len);
+            if (got < 0) return would_block() ? 0 : -1;
+            if (from_len >= (socklen_t)sizeof(from) && from.sin_family == AF_INET && from.sin_port == peer.sin_port
+                && from.sin_addr.s_addr == peer.sin_addr.s_addr) {
+                return (int)got;
+            }
+        }
+    }
+
+    int due = -1;
+    for (int i = 0; i < l->queue_count; i++) {
+        if (l->queue[i].deliver_at <= now_ns && (due < 0 || l->queue[i].deliver_at < l->queue[due].deliver_at)) due = i;
+    }
+    if (due < 0) return 0;
+    NetPacket* p = &l->queue[due];
+    int size = p->size <= capacity ? p->size : capacity;
+    memcpy(buffer, p->data, (size_t)size);
+    *p = l->queue[--l->queue_count];
+    return size;
+}
+
+void net_close(NetLink* l) {
+    if (l->kind == NET_UDP && l->socket != INVALID_SOCK) close_socket(l->socket);
+#ifdef _WIN32
+    if (l->wsa_started) WSACleanup();
+#endif
+    l->wsa_started = false;
+    l->socket = INVALID_SOCK;
+    l->queue_count = 0;
+}
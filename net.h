@@ -0,0 +1,53 @@
+#ifndef NET_H
+#define NET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define NET_MAX_PACKET 512
+#define NET_LOOPBACK_QUEUE 256
+
+// A connectionless datagram link to one peer. UDP for real cabinets; the loopback kind joins two
+// links inside one process and delivers each packet after a latency plus random jitter, dropping
+// some, so netplay can be exercised deterministically without a network. Time for the loopback
+// is whatever clock the caller passes in, in nanoseconds
+typedef enum {
+    NET_UDP,
+    NET_LOOPBACK,
+} NetKind;
+
+typedef struct {
+    uint64_t deliver_at;
+    uint16_t size;
+    uint8_t data[NET_MAX_PACKET];
+} NetPacket;
+
+typedef struct NetLink NetLink;
+
+struct NetLink {
+    NetKind kind;
+    // udp
+    intptr_t socket;
+    uint8_t peer_addr[128];     // sockaddr_storage sized, datagrams from any other address are dropped
+    uint32_t peer_addr_len;
+    bool wsa_started;           // windows: WSAStartup succeeded, net_close owes a WSACleanup
+    // loopback: packets sent to this link wait in its queue until deliver_at
+    NetLink* peer;
+    NetPacket queue[NET_LOOPBACK_QUEUE];
+    int queue_count;
+    uint64_t latency_ns;
+    uint64_t jitter_ns;
+    uint32_t loss_permille;
+    uint64_t rng;
+};
+
+// binds local_port and sends to host:port; the socket never blocks
+bool net_udp_open(NetLink* l, int local_port, const char* peer_host, int peer_port);
+// a and b talk to each other, each direction with the given one-way latency, jitter and loss
+void net_loopback_pair(NetLink* a, NetLink* b, double latency_ms, double jitter_ms, double loss, uint64_t seed);
+bool net_send(NetLink* l, const void* data, int size, uint64_t now_ns);
+// size of the next packet that has arrived by now_ns, 0 when there is none, -1 on error
+int net_recv(NetLink* l, void* buffer, int capacity, uint64_t now_ns);
+void net_close(NetLink* l);
+
+#endif
@@ -0,0 +1,56 @@
+#include "pacing.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char* pace_names[] = {"vsync", "hybrid", "uncapped"};
+
+bool pacing_parse_mode(const char* name, PaceMode* mode) {
+    for (int i = 0; i < (int)SDL_arraysize(pace_names); i++) {
+        if (strcmp(name, pace_names[i]) == 0) {
+            *mode = (PaceMode)i;
+            return true;
+        }
+    }
+    printf("Unknown pacing mode '%s' (vsync, hybrid, uncapped)\n", name);
+    return false;
+}
+
+void pacer_init(Pacer* p, SDL_Renderer* renderer, PaceMode mode, int target_fps) {
+    p->frame_ns = SDL_NS_PER_SECOND / (Uint64)target_fps;
+    p->deadline = SDL_GetTicksNS() + p->frame_ns;
+
+    if (mode == PACE_VSYNC && !SDL_SetRenderVSync(renderer, 1)) {
+        printf("Error_vsync: %s, falling back to hybrid pacing\n", SDL_GetError());
+        mode = PACE_HYBRID;
+    }
+    if (mode != PACE_VSYNC) {
+        SDL_SetRenderVSync(renderer, SDL_RENDERER_VSYNC_DISABLED);
+    }
+    p->mode = mode;
+}
+
+void pacer_wait(Pacer* p) {
+    if (p->mode != PACE_HYBRID) return;
+
+    Uint64 now = SDL_GetTicksNS();
+    if (now >= p->deadline) {
+        // running late: don't try to claw back missed frames, just restart the cadence
+        if (now - p->deadline > p->frame_ns) p->deadline = now;
+        p->deadline += p->frame_ns;
+        return;
+    }
+
+    Uint64 remaining = p->deadline - now;
+    if (remaining > PACE_SPIN_NS) {
+        SDL_DelayNS(remaining - PACE_SPIN_NS);
+    }
+    while (SDL_GetTicksNS() < p->deadline) {
+    }
+    p->deadline += p->frame_ns;
+}
+
+bool pacer_idle(Pacer* p, int timeout_ms) {
+    bool woken = SDL_WaitEventTimeout(NULL, timeout_ms);
+    p->deadline = SDL_GetTicksNS() + p->frame_ns;
+    return woken;
+}
@@ -0,0 +1,29 @@
+#ifndef PACING_H
+#define PACING_H
+
+#include <SDL3/SDL.h>
+
+#define PACE_SPIN_NS (1500 * SDL_NS_PER_US)
+
+typedef enum {
+    PACE_VSYNC,
+    PACE_HYBRID,
+    PACE_UNCAPPED,
+} PaceMode;
+
+// VSYNC lets the renderer block in present. HYBRID sleeps until just before the next
+// deadline and spins the rest on SDL_GetTicksNS. UNCAPPED never waits
+typedef struct {
+    PaceMode mode;
+    Uint64 frame_ns;
+    Uint64 deadline;
+} Pacer;
+
+bool pacing_parse_mode(const char* name, PaceMode* mode);
+void pacer_init(Pacer* p, SDL_Renderer* renderer, PaceMode mode, int target_fps);
+void pacer_wait(Pacer* p);
+// for frames with nothing to animate: blocks until an event is queued or timeout_ms passes,
+// then restarts the frame cadence from now. true when woken by an event
+bool pacer_idle(Pacer* p, int timeout_ms);
+
+#endif
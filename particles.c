@@ -0,0 +1,129 @@
+#include "particles.h"
+#include <string.h>
+
+void particles_init(ParticleSystem* p, uint64_t seed) {
+    p->rng = seed ? seed : 0x9E3779B97F4A7C15ull;
+    for (int q = 0; q < PARTICLE_CAPACITY; q++) {
+        int* i = &p->indices[q * 6];
+        int v = q * 4;
+        i[0] = v; i[1] = v + 1; i[2] = v + 2;
+        i[3] = v + 2; i[4] = v + 3; i[5] = v;
+    }
+    particles_clear(p);
+}
+
+void particles_clear(ParticleSystem* p) {
+    p->count = 0;
+    p->vertex_count = 0;
+    p->fade_phase = 0;
+}
+
+// [0, 1)
+static float random01(ParticleSystem* p) {
+    p->rng ^= p->rng << 13;
+    p->rng ^= p->rng >> 7;
+    p->rng ^= p->rng << 17;
+    return (float)(p->rng >> 40) / 16777216.0f;
+}
+
+void particles_burst(ParticleSystem* p, SimRect from, SimColor c, int n, float speed, float life) {
+    if (n > PARTICLE_CAPACITY - p->count) n = PARTICLE_CAPACITY - p->count;
+    ParticleColor colour = {c.r / 255.0f, c.g / 255.0f, c.b / 255.0f, c.a / 255.0f};
+    for (int k = 0; k < n; k++) {
+        int i = p->count++;
+        p->x[i] = from.x + random01(p) * from.w;
+        p->y[i] = from.y + random01(p) * from.h;
+        // mostly upwards and out, gravity brings them back down
+        p->vx[i] = (random01(p) * 2.0f - 1.0f) * speed;
+        p->vy[i] = (random01(p) * -1.3f + 0.3f) * speed;
+        p->life[i] = life * (0.5f + 0.5f * random01(p));
+        p->fade[i] = 1.0f / p->life[i];
+        p->color[i] = colour;
+        ParticleColor* vc = &p->vertex_color[i * 4];
+        vc[0] = colour;
+        vc[1] = colour;
+        vc[2] = colour;
+        vc[3] = colour;
+    }
+}
+
+void particles_update(ParticleSystem* p, float dt) {
+    float* restrict x = p->x;
+    float* restrict y = p->y;
+    float* restrict vx = p->vx;
+    float* restrict vy = p->vy;
+    float* restrict life = p->life;
+    // whole blocks of PARTICLE_LANES, so the inner loop has a fixed trip count and vectorises
+    // even at -O2; the slots past count in the last block are free and may hold anything
+    int blocks = (p->count + PARTICLE_LANES - 1) / PARTICLE_LANES;
+    for (int b = 0; b < blocks; b++) {
+        for (int k = 0; k < PARTICLE_LANES; k++) {
+            int i = b * PARTICLE_LANES + k;
+            vy[i] += PARTICLE_GRAVITY * dt;
+            x[i] += vx[i] * dt;
+            y[i] += vy[i] * dt;
+            life[i] -= dt;
+        }
+    }
+
+    // retire the dead and the fallen by moving the last live particle into their slot; most
+    // blocks have nobody to retire and are passed over with one branch
+    int n = p->count;
+    for (int i = 0; i < n;) {
+        if (i % PARTICLE_LANES == 0 && i + PARTICLE_LANES <= n) {
+            int retire = 0;
+            for (int k = 0; k < PARTICLE_LANES; k++) retire |= (life[i + k] <= 0.0f) | (y[i + k] >= HEIGHT);
+            if (!retire) {
+                i += PARTICLE_LANES;
+                continue;
+            }
+        }
+        if (life[i] > 0.0f && y[i] < HEIGHT) {
+            i++;
+            continue;
+        }
+        n -= 1;
+        x[i] = x[n];
+        y[i] = y[n];
+        vx[i] = vx[n];
+        vy[i] = vy[n];
+        life[i] = life[n];
+        p->fade[i] = p->fade[n];
+        p->color[i] = p->color[n];
+        memcpy(&p->vertex_color[i * 4], &p->vertex_color[n * 4], sizeof(ParticleColor) * 4);
+    }
+    p->count = n;
+}
+
+void particles_build(ParticleSystem* p) {
+    const float h = PARTICLE_SIZE * 0.5f;
+    const float* restrict px = p->x;
+    const float* restrict py = p->y;
+    float* restrict xy = p->xy;
+    int n = p->count;
+    for (int i = 0; i < n; i++) {
+        float x0 = px[i] - h, x1 = px[i] + h;
+        float y0 = py[i] - h, y1 = py[i] + h;
+        float* v = &xy[i * 8];
+        v[0] = x0; v[1] = y0;
+        v[2] = x1; v[3] = y0;
+        v[4] = x1; v[5] = y1;
+        v[6] = x0; v[7] = y1;
+    }
+
+    // a spark's alpha lags its life by at most PARTICLE_FADE_EVERY - 1 frames
+    int blocks = (n + PARTICLE_LANES - 1) / PARTICLE_LANES;
+    for (int b = (int)(p->fade_phase % PARTICLE_FADE_EVERY); b < blocks; b += PARTICLE_FADE_EVERY) {
+        int end = (b + 1) * PARTICLE_LANES < n ? (b + 1) * PARTICLE_LANES : n;
+        for (int i = b * PARTICLE_LANES; i < end; i++) {
+            float a = p->color[i].a * p->life[i] * p->fade[i];
+            ParticleColor* vc = &p->vertex_color[i * 4];
+            vc[0].a = a;
+            vc[1].a = a;
+            vc[2].a = a;
+            vc[3].a = a;
+        }
+    }
+    p->fade_phase += 1;
+    p->vertex_count = n * 4;
+}
@@ -0,0 +1,49 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include "sim.h"
+
+#define PARTICLE_CAPACITY 65536     // a multiple of PARTICLE_LANES
+#define PARTICLE_LANES 8
+#define PARTICLE_SIZE 3.0f
+#define PARTICLE_GRAVITY 900.0f
+#define PARTICLE_FADE_EVERY 4       // frames between alpha refreshes of any one spark
+
+// Cosmetic sparks, kept out of the sim so they never touch determinism or the checksum. One
+// array per field; live particles are [0, count) and a dead one is replaced by the last, like
+// balls, so [count, PARTICLE_CAPACITY) is the free list and the update loop runs over dense
+// arrays with no branches. Bursts past capacity are cut short rather than growing anything.
+// particles_build() writes every live particle as a quad into xy/vertex_color, laid out for one
+// SDL_RenderGeometryRaw call against the fixed index buffer (see particles_flush in render.c).
+// Positions are rewritten every frame; vertex colours belong to the slot, are set by the burst
+// and moved with the particle, and only a rotating 1/PARTICLE_FADE_EVERY of the blocks get their
+// alpha refreshed per frame, which keeps the stores per frame at half of a full rebuild
+typedef struct {
+    float r, g, b, a;       // same layout as SDL_FColor
+} ParticleColor;
+
+typedef struct {
+    float x[PARTICLE_CAPACITY];
+    float y[PARTICLE_CAPACITY];
+    float vx[PARTICLE_CAPACITY];
+    float vy[PARTICLE_CAPACITY];
+    float life[PARTICLE_CAPACITY];      // seconds left
+    float fade[PARTICLE_CAPACITY];      // 1 / starting life, alpha is life * fade
+    ParticleColor color[PARTICLE_CAPACITY];
+    int count;
+    uint64_t rng;
+    uint32_t fade_phase;
+    int vertex_count;
+    float xy[PARTICLE_CAPACITY * 4 * 2];
+    ParticleColor vertex_color[PARTICLE_CAPACITY * 4];
+    int indices[PARTICLE_CAPACITY * 6];
+} ParticleSystem;
+
+void particles_init(ParticleSystem* p, uint64_t seed);
+void particles_clear(ParticleSystem* p);
+// n sparks from random points inside the rect, flying out at up to speed px/s
+void particles_burst(ParticleSystem* p, SimRect from, SimColor c, int n, float speed, float life);
+void particles_update(ParticleSystem* p, float dt);
+void particles_build(ParticleSystem* p);
+
+#endif
@@ -0,0 +1,160 @@
+#include "profiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+_Static_assert((PROF_RING_FRAMES & (PROF_RING_FRAMES - 1)) == 0, "ring is indexed with a mask");
+
+#define SLOT(f) ((f) & (PROF_RING_FRAMES - 1))
+
+static const char* section_names[MAX_PROF_SECTIONS] = {"events", "update", "ui", "draw", "present"};
+
+void profiler_init(Profiler* p) {
+    SDL_SetAtomicU32(&p->head, 0);
+    p->current = (ProfFrame) {0};
+    for (int i = 0; i < MAX_PROF_SECTIONS; i++) p->open[i] = -1;
+    p->ms_per_count = 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+void profiler_frame_begin(Profiler* p) {
+    p->current.start = SDL_GetPerformanceCounter();
+    p->current.end = p->current.start;
+    p->current.span_count = 0;
+    p->current.update_ticks = 0;
+    p->current.draw_calls = 0;
+    p->current.dropped_spans = 0;
+    for (int i = 0; i < MAX_PROF_SECTIONS; i++) p->open[i] = -1;
+}
+
+void profiler_frame_end(Profiler* p) {
+    p->current.end = SDL_GetPerformanceCounter();
+    uint32_t head = SDL_GetAtomicU32(&p->head);
+    p->frames[SLOT(head)] = p->current;
+    SDL_MemoryBarrierRelease();
+    SDL_SetAtomicU32(&p->head, head + 1 == 2 * PROF_RING_FRAMES ? PROF_RING_FRAMES : head + 1);
+}
+
+void profiler_begin(Profiler* p, ProfSection s) {
+    // a long catch-up (ticks after an idle wake) can run out of spans; count what is lost so the
+    // dump says so, and leave the section closed so its profiler_end() doesn't stretch an old span
+    if (p->current.span_count >= PROF_MAX_SPANS) {
+        p->current.dropped_spans += 1;
+        p->open[s] = -1;
+        return;
+    }
+    int i = p->current.span_count++;
+    p->current.spans[i] = (ProfSpan) {.section = (uint8_t)s, .start = SDL_GetPerformanceCounter()};
+    p->current.spans[i].end = p->current.spans[i].start;
+    p->open[s] = i;
+}
+
+void profiler_end(Profiler* p, ProfSection s) {
+    if (p->open[s] < 0) return;
+    p->current.spans[p->open[s]].end = SDL_GetPerformanceCounter();
+    p->open[s] = -1;
+}
+
+void profiler_count_ticks(Profiler* p, int ticks) {
+    p->current.update_ticks += ticks;
+}
+
+void profiler_count_draws(Profiler* p, int calls) {
+    p->current.draw_calls += calls;
+}
+
+static int compare_floats(const void* a, const void* b) {
+    float fa = *(const float*)a, fb = *(const float*)b;
+    return (fa > fb) - (fa < fb);
+}
+
+// frames published so far, oldest first; index 0 has no predecessor to measure an interval from
+static int published(Profiler* p, uint32_t* first) {
+    uint32_t head = SDL_GetAtomicU32(&p->head);
+    SDL_MemoryBarrierAcquire();
+    int count = head < PROF_RING_FRAMES ? (int)head : PROF_RING_FRAMES;
+    *first = head - (uint32_t)count;
+    return count;
+}
+
+void profiler_stats(Profiler* p, ProfStats* out) {
+    static float intervals[PROF_RING_FRAMES];
+    static float work[PROF_RING_FRAMES];
+    *out = (ProfStats) {0};
+
+    uint32_t first;
+    int count = published(p, &first);
+    if (count < 2) return;
+
+    long ticks = 0, draws = 0;
+    int n = 0;
+    out->dropped_spans = p->frames[SLOT(first)].dropped_spans;
+    for (int k = 1; k < count; k++) {
+        const ProfFrame* prev = &p->frames[SLOT(first + k - 1)];
+        const ProfFrame* cur = &p->frames[SLOT(first + k)];
+        intervals[n] = (float)((cur->start - prev->start) * p->ms_per_count);
+        work[n] = (float)((cur->end - cur->start) * p->ms_per_count);
+        ticks += cur->update_ticks;
+        draws += cur->draw_calls;
+        out->dropped_spans += cur->dropped_spans;
+        n++;
+    }
+    qsort(intervals, n, sizeof(float), compare_floats);
+    qsort(work, n, sizeof(float), compare_floats);
+    out->frame_p50_ms = intervals[n / 2];
+    out->frame_p99_ms = intervals[(n * 99) / 100];
+    out->work_p50_ms = work[n / 2];
+    out->ticks_per_frame = (float)ticks / n;
+    out->draw_calls = (float)draws / n;
+}
+
+// writes <prefix>.csv (one row per frame) and <prefix>.json (Chrome trace, chrome://tracing or Perfetto)
+bool profiler_dump(Profiler* p, const char* prefix) {
+    char path[512];
+    uint32_t first;
+    int count = published(p, &first);
+    if (count == 0) return true;
+    uint64_t origin = p->frames[SLOT(first)].start;
+
+    snprintf(path, sizeof(path), "%s.csv", prefix);
+    FILE* csv = fopen(path, "w");
+    if (!csv) {
+        printf("Error opening profile dump: %s\n", path);
+        return false;
+    }
+    fprintf(csv, "frame,start_ms,work_ms");
+    for (int s = 0; s < MAX_PROF_SECTIONS; s++) fprintf(csv, ",%s_ms", section_names[s]);
+    fprintf(csv, ",update_ticks,draw_calls,dropped_spans\n");
+    for (int k = 0; k < count; k++) {
+        const ProfFrame* fr = &p->frames[SLOT(first + (uint32_t)k)];
+        double totals[MAX_PROF_SECTIONS] = {0};
+        for (int i = 0; i < fr->span_count; i++) {
+            totals[fr->spans[i].section] += (fr->spans[i].end - fr->spans[i].start) * p->ms_per_count;
+        }
+        fprintf(csv, "%d,%.4f,%.4f", k, (fr->start - origin) * p->ms_per_count, (fr->end - fr->start) * p->ms_per_count);
+        for (int s = 0; s < MAX_PROF_SECTIONS; s++) fprintf(csv, ",%.4f", totals[s]);
+        fprintf(csv, ",%d,%d,%d\n", fr->update_ticks, fr->draw_calls, fr->dropped_spans);
+    }
+    fclose(csv);
+
+    snprintf(path, sizeof(path), "%s.json", prefix);
+    FILE* trace = fopen(path, "w");
+    if (!trace) {
+        printf("Error opening profile dump: %s\n", path);
+        return false;
+    }
+    double us = p->ms_per_count * 1000.0;
+    fprintf(trace, "{\"traceEvents\":[\n");
+    for (int k = 0; k < count; k++) {
+        const ProfFrame* fr = &p->frames[SLOT(first + (uint32_t)k)];
+        fprintf(trace, "%s{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"ticks\":%d,\"draw_calls\":%d,\"dropped_spans\":%d}}",
+                k == 0 ? "" : ",\n", (fr->start - origin) * us, (fr->end - fr->start) * us, fr->update_ticks, fr->draw_calls,
+                fr->dropped_spans);
+        for (int i = 0; i < fr->span_count; i++) {
+            const ProfSpan* sp = &fr->spans[i];
+            fprintf(trace, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                    section_names[sp->section], (sp->start - origin) * us, (sp->end - sp->start) * us);
+        }
+    }
+    fprintf(trace, "\n]}\n");
+    fclose(trace);
+    return true;
+}
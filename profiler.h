@@ -0,0 +1,65 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <SDL3/SDL.h>
+
+#define PROF_RING_FRAMES 1024     // a power of two
+#define PROF_MAX_SPANS 24
+
+typedef enum {
+    PROF_EVENTS=0,
+    PROF_UPDATE,
+    PROF_UI,
+    PROF_DRAW,
+    PROF_PRESENT,
+    MAX_PROF_SECTIONS
+} ProfSection;
+
+typedef struct {
+    uint8_t section;
+    uint64_t start;
+    uint64_t end;
+} ProfSpan;
+
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    int span_count;
+    ProfSpan spans[PROF_MAX_SPANS];
+    int update_ticks;
+    int draw_calls;
+    int dropped_spans;      // spans begun after spans[] was full, their time is only in the frame's
+} ProfFrame;
+
+typedef struct {
+    float frame_p50_ms;
+    float frame_p99_ms;
+    float work_p50_ms;
+    float ticks_per_frame;
+    float draw_calls;
+    int dropped_spans;      // summed over the ring, nonzero means the CSV and trace are missing spans
+} ProfStats;
+
+// single-producer ring of the last PROF_RING_FRAMES frames. The main loop fills `current`
+// and publishes it with one release store of `head`; readers only look at published slots.
+// head stays in [0, 2 * PROF_RING_FRAMES): below PROF_RING_FRAMES the ring is still filling, and
+// from there it steps back by PROF_RING_FRAMES instead of growing, which keeps the same slot
+typedef struct {
+    ProfFrame frames[PROF_RING_FRAMES];
+    SDL_AtomicU32 head;
+    ProfFrame current;
+    int open[MAX_PROF_SECTIONS];
+    double ms_per_count;
+} Profiler;
+
+void profiler_init(Profiler* p);
+void profiler_frame_begin(Profiler* p);
+void profiler_frame_end(Profiler* p);
+void profiler_begin(Profiler* p, ProfSection s);
+void profiler_end(Profiler* p, ProfSection s);
+void profiler_count_ticks(Profiler* p, int ticks);
+void profiler_count_draws(Profiler* p, int calls);
+void profiler_stats(Profiler* p, ProfStats* out);
+bool profiler_dump(Profiler* p, const char* prefix);
+
+#endif
@@ -0,0 +1,163 @@
+#include "render.h"
+#include <stdio.h>
+#include <string.h>
+
+void shape_batch_init(ShapeBatch* b) {
+    b->brick_quads = 0;
+    b->quad_count = 0;
+    b->bricks_valid = false;
+    for (int q = 0; q < BATCH_MAX_QUADS; q++) {
+        int* i = &b->indices[q * 6];
+        int v = q * 4;
+        i[0] = v; i[1] = v + 1; i[2] = v + 2;
+        i[3] = v + 2; i[4] = v + 3; i[5] = v;
+    }
+}
+
+static void write_quad(SDL_Vertex* v, SDL_FRect r, SDL_FColor fc) {
+    v[0] = (SDL_Vertex) {.position = {r.x, r.y}, .color = fc};
+    v[1] = (SDL_Vertex) {.position = {r.x + r.w, r.y}, .color = fc};
+    v[2] = (SDL_Vertex) {.position = {r.x + r.w, r.y + r.h}, .color = fc};
+    v[3] = (SDL_Vertex) {.position = {r.x, r.y + r.h}, .color = fc};
+}
+
+void shape_batch_update_bricks(ShapeBatch* b, const SimWorld* w) {
+    const BrickField* f = &w->bricks;
+    if (b->bricks_valid && memcmp(b->brick_rows, f->row_alive, sizeof(b->brick_rows)) == 0) {
+        b->quad_count = b->brick_quads;
+        return;
+    }
+
+    int q = 0;
+    for (int i = 0; i < f->rows * f->cols; i++) {
+        if (brick_alive(f, i)) {
+            SDL_FRect r = {f->x[i], f->y[i], f->w[i], f->h[i]};
+            SimColor col = f->color[i];
+            SDL_FColor c = {col.r / 255.0f, col.g / 255.0f, col.b / 255.0f, col.a / 255.0f};
+            write_quad(&b->vertices[q * 4], r, c);
+            q += 1;
+        }
+    }
+    memcpy(b->brick_rows, f->row_alive, sizeof(b->brick_rows));
+    b->brick_quads = q;
+    b->quad_count = q;
+    b->bricks_valid = true;
+}
+
+void shape_batch_add(ShapeBatch* b, SDL_FRect r, SDL_Color c) {
+    if (b->quad_count >= BATCH_MAX_QUADS) return;
+    SDL_FColor fc = {c.r / 255.0f, c.g / 255.0f, c.b / 255.0f, c.a / 255.0f};
+    write_quad(&b->vertices[b->quad_count * 4], r, fc);
+    b->quad_count += 1;
+}
+
+// returns the number of draw calls issued
+int shape_batch_flush(ShapeBatch* b, SDL_Renderer* renderer) {
+    int calls = 0;
+    if (b->quad_count > 0) {
+        if (!SDL_RenderGeometry(renderer, NULL, b->vertices, b->quad_count * 4, b->indices, b->quad_count * 6)) {
+            printf("Error_shape_geometry: %s\n", SDL_GetError());
+        }
+        calls = 1;
+    }
+    b->quad_count = b->brick_quads;
+    return calls;
+}
+
+_Static_assert(sizeof(ParticleColor) == sizeof(SDL_FColor), "particle colours are passed as SDL_FColor");
+
+int particles_flush(const ParticleSystem* p, SDL_Renderer* renderer) {
+    if (p->vertex_count == 0) return 0;
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    if (!SDL_RenderGeometryRaw(renderer, NULL, p->xy, 2 * sizeof(float), (const SDL_FColor*)p->vertex_color,
+                               sizeof(ParticleColor), NULL, 0, p->vertex_count, p->indices, p->vertex_count / 4 * 6, sizeof(int))) {
+        printf("Error_particle_geometry: %s\n", SDL_GetError());
+    }
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    return 1;
+}
+
+//::render scaler
+
+bool render_scaler_init(RenderScaler* s, SDL_Renderer* renderer, float scale, Uint64 frame_ns) {
+    memset(s, 0, sizeof(*s));
+    s->automatic = scale <= 0.0f;
+    s->requested = scale;
+    // the rest of the frame is left to the sim, the final stretch and present
+    s->budget_ns = frame_ns * 6 / 10;
+    if (!render_scaler_resize(s, renderer)) return false;
+    // auto starts at full quality and only drops once frames turn out too slow
+    s->scale = s->automatic ? s->fit_scale : SDL_min(s->requested, s->fit_scale);
+    return true;
+}
+
+bool render_scaler_resize(RenderScaler* s, SDL_Renderer* renderer) {
+    int w, h;
+    if (!SDL_GetCurrentRenderOutputSize(renderer, &w, &h)) {
+        printf("Error_render_scale: %s\n", SDL_GetError());
+        return false;
+    }
+    s->fit_scale = SDL_clamp(SDL_min((float)w / WIDTH, (float)h / HEIGHT), RENDER_SCALE_MIN, RENDER_SCALE_MAX);
+    s->dest.w = WIDTH * s->fit_scale;
+    s->dest.h = HEIGHT * s->fit_scale;
+    s->dest.x = SDL_floorf((w - s->dest.w) * 0.5f);
+    s->dest.y = SDL_floorf((h - s->dest.h) * 0.5f);
+
+    int target_w = (int)SDL_ceilf(WIDTH * s->fit_scale);
+    int target_h = (int)SDL_ceilf(HEIGHT * s->fit_scale);
+    if (s->target == NULL || target_w != s->target_w || target_h != s->target_h) {
+        if (s->target) SDL_DestroyTexture(s->target);
+        s->target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_XRGB8888, SDL_TEXTUREACCESS_TARGET, target_w, target_h);
+        if (s->target == NULL) {
+            printf("Error_render_scale: %s\n", SDL_GetError());
+            return false;
+        }
+        SDL_SetTextureScaleMode(s->target, SDL_SCALEMODE_LINEAR);
+        s->target_w = target_w;
+        s->target_h = target_h;
+    }
+    s->scale = s->automatic ? SDL_min(s->scale, s->fit_scale) : SDL_min(s->requested, s->fit_scale);
+    s->spent_ns = 0;
+    s->frames = 0;
+    return true;
+}
+
+void render_scaler_begin(RenderScaler* s, SDL_Renderer* renderer) {
+    s->begin_ns = SDL_GetTicksNS();
+    SDL_SetRenderTarget(renderer, s->target);
+    SDL_SetRenderScale(renderer, s->scale, s->scale);
+}
+
+// cost goes with the pixel count, so the scale that fits is scale * sqrt(budget / cost). Shrink
+// as soon as a window of frames is over budget, grow back only well under it and a step at a time
+static void adapt(RenderScaler* s) {
+    double cost = (double)s->spent_ns / s->frames;
+    s->spent_ns = 0;
+    s->frames = 0;
+    if (cost <= 0.0 || (cost < s->budget_ns && cost > 0.6 * s->budget_ns)) return;
+    double want = s->scale * SDL_sqrt(0.8 * s->budget_ns / cost);
+    want = SDL_min(want, s->scale * 1.1);
+    s->scale = (float)SDL_clamp(want, RENDER_SCALE_MIN, s->fit_scale);
+}
+
+void render_scaler_end(RenderScaler* s, SDL_Renderer* renderer) {
+    // draws are queued until a flush; a software renderer does the actual work here
+    SDL_FlushRenderer(renderer);
+    s->spent_ns += SDL_GetTicksNS() - s->begin_ns;
+    s->frames += 1;
+
+    SDL_SetRenderTarget(renderer, NULL);
+    if (s->dest.x > 0.0f || s->dest.y > 0.0f) {
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderClear(renderer);
+    }
+    SDL_FRect src = {0, 0, WIDTH * s->scale, HEIGHT * s->scale};
+    SDL_RenderTexture(renderer, s->target, &src, &s->dest);
+
+    if (s->automatic && s->frames == RENDER_SCALE_FRAMES) adapt(s);
+}
+
+void render_scaler_destroy(RenderScaler* s) {
+    if (s->target) SDL_DestroyTexture(s->target);
+    s->target = NULL;
+}
@@ -0,0 +1,63 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <SDL3/SDL.h>
+#include "sim.h"
+#include "particles.h"
+
+#define BATCH_MAX_QUADS (MAX_BRICKS + SIM_MAX_BALLS + 16)
+
+// untextured quads drawn with one SDL_RenderGeometry call. The brick field sits at the
+// front of the buffer and is only rebuilt when a brick's alive bit flips; per-frame
+// shapes are appended behind it and dropped again after each flush
+typedef struct {
+    SDL_Vertex vertices[BATCH_MAX_QUADS * 4];
+    int indices[BATCH_MAX_QUADS * 6];
+    int brick_quads;
+    int quad_count;
+    uint64_t brick_rows[BRICK_MAX_ROWS];
+    bool bricks_valid;
+} ShapeBatch;
+
+void shape_batch_init(ShapeBatch* b);
+void shape_batch_update_bricks(ShapeBatch* b, const SimWorld* w);
+void shape_batch_add(ShapeBatch* b, SDL_FRect r, SDL_Color c);
+int shape_batch_flush(ShapeBatch* b, SDL_Renderer* renderer);
+// draws what particles_build() last wrote, alpha blended, in one call
+int particles_flush(const ParticleSystem* p, SDL_Renderer* renderer);
+
+#define RENDER_SCALE_MIN 0.25
+#define RENDER_SCALE_MAX 8.0
+#define RENDER_SCALE_FRAMES 30      // frames of draw time averaged before an automatic rescale
+
+// The game draws in WIDTH x HEIGHT sim coordinates into the top left WIDTH*scale x HEIGHT*scale
+// pixels of an offscreen target, which is then stretched into the largest centred box of the
+// game's aspect that the window's pixel size allows. The target is allocated once per window size at the largest
+// scale that box can show, so changing scale never reallocates. In auto mode the scale follows
+// the measured draw time (draw calls plus the flush that executes them) to keep it within
+// budget_ns: pixel count, and with it the cost of a software renderer, goes with scale squared
+typedef struct {
+    SDL_Texture* target;
+    int target_w;
+    int target_h;
+    float scale;
+    float requested;        // fixed scale asked for, 0 in auto mode
+    float fit_scale;        // the window's pixels per game pixel, the useful maximum
+    bool automatic;
+    Uint64 budget_ns;
+    Uint64 begin_ns;
+    Uint64 spent_ns;
+    int frames;
+    SDL_FRect dest;         // where the game lands in the window, in window pixels
+} RenderScaler;
+
+// scale 0 = automatic; frame_ns is the frame period the draw has to fit in
+bool render_scaler_init(RenderScaler* s, SDL_Renderer* renderer, float scale, Uint64 frame_ns);
+// call after the window's pixel size changed
+bool render_scaler_resize(RenderScaler* s, SDL_Renderer* renderer);
+// points the renderer at the target; draw the frame in sim coordinates between begin and end
+void render_scaler_begin(RenderScaler* s, SDL_Renderer* renderer);
+void render_scaler_end(RenderScaler* s, SDL_Renderer* renderer);
+void render_scaler_destroy(RenderScaler* s);
+
+#endif
@@ -0,0 +1,145 @@
+#include "replay.h"
+#include <string.h>
+
+static const char replay_magic[4] = {'2', '0', 'G', 'R'};
+
+static void write_u64(FILE* fp, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        fputc((int)((v >> (8 * i)) & 0xFF), fp);
+    }
+}
+
+static bool read_u64(FILE* fp, uint64_t* v, int bytes) {
+    *v = 0;
+    for (int i = 0; i < bytes; i++) {
+        int c = fgetc(fp);
+        if (c == EOF) return false;
+        *v |= (uint64_t)c << (8 * i);
+    }
+    return true;
+}
+
+static void write_varint(FILE* fp, uint64_t v) {
+    while (v >= 0x80) {
+        fputc((int)((v & 0x7F) | 0x80), fp);
+        v >>= 7;
+    }
+    fputc((int)v, fp);
+}
+
+static bool read_varint(FILE* fp, uint64_t* v) {
+    *v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = fgetc(fp);
+        if (c == EOF) return false;
+        *v |= (uint64_t)(c & 0x7F) << shift;
+        if ((c & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+bool replay_record_open(Replay* r, const char* path, uint32_t tick_rate, uint64_t seed, uint64_t level_hash) {
+    memset(r, 0, sizeof(*r));
+    r->fp = fopen(path, "wb");
+    if (!r->fp) {
+        printf("Error opening replay for recording: %s\n", path);
+        return false;
+    }
+    r->tick_rate = tick_rate;
+    r->seed = seed;
+    r->level_hash = level_hash;
+    fwrite(replay_magic, 1, sizeof(replay_magic), r->fp);
+    write_u64(r->fp, REPLAY_VERSION, 2);
+    write_u64(r->fp, tick_rate, 4);
+    write_u64(r->fp, seed, 8);
+    write_u64(r->fp, level_hash, 8);
+    return true;
+}
+
+void replay_record_tick(Replay* r, const SimInput* in) {
+    uint8_t mask = sim_input_to_mask(in);
+    if (mask != r->mask) {
+        write_varint(r->fp, r->run);
+        fputc(mask, r->fp);
+        r->mask = mask;
+        r->run = 0;
+    }
+    r->run += 1;
+    r->ticks += 1;
+}
+
+bool replay_record_close(Replay* r, uint64_t checksum) {
+    write_varint(r->fp, r->run);
+    fputc(REPLAY_END, r->fp);
+    write_u64(r->fp, r->ticks, 8);
+    write_u64(r->fp, checksum, 8);
+    bool ok = !ferror(r->fp);
+    if (fclose(r->fp) != 0) ok = false;
+    r->fp = NULL;
+    if (!ok) printf("Error writing replay\n");
+    return ok;
+}
+
+// pulls the next record; past REPLAY_END the trailer is read and playback stops
+static bool read_record(Replay* r) {
+    int c;
+    if (!read_varint(r->fp, &r->run) || (c = fgetc(r->fp)) == EOF) {
+        printf("Error - replay truncated\n");
+        return false;
+    }
+    r->next_mask = (uint8_t)c;
+    if (r->next_mask == REPLAY_END) {
+        if (!read_u64(r->fp, &r->total_ticks, 8) || !read_u64(r->fp, &r->checksum, 8)) {
+            printf("Error - replay trailer missing\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool replay_play_open(Replay* r, const char* path) {
+    memset(r, 0, sizeof(*r));
+    r->fp = fopen(path, "rb");
+    if (!r->fp) {
+        printf("Error opening replay: %s\n", path);
+        return false;
+    }
+
+    char magic[4];
+    uint64_t version, tick_rate;
+    if (fread(magic, 1, sizeof(magic), r->fp) != sizeof(magic) || memcmp(magic, replay_magic, sizeof(magic)) != 0
+        || !read_u64(r->fp, &version, 2) || version < 1 || version > REPLAY_VERSION
+        || !read_u64(r->fp, &tick_rate, 4) || !read_u64(r->fp, &r->seed, 8)
+        || (version >= 2 && !read_u64(r->fp, &r->level_hash, 8))
+        || !read_record(r)) {
+        printf("Error - not a replay file: %s\n", path);
+        replay_play_close(r);
+        return false;
+    }
+    r->tick_rate = (uint32_t)tick_rate;
+    return true;
+}
+
+bool replay_play_tick(Replay* r, SimInput* in) {
+    if (r->finished) return false;
+    while (r->run == 0) {
+        if (r->next_mask == REPLAY_END) {
+            r->finished = true;
+            return false;
+        }
+        r->mask = r->next_mask;
+        if (!read_record(r)) {
+            r->finished = true;
+            return false;
+        }
+    }
+    r->run -= 1;
+    r->ticks += 1;
+    *in = sim_mask_to_input(r->mask);
+    return true;
+}
+
+void replay_play_close(Replay* r) {
+    if (r->fp) fclose(r->fp);
+    r->fp = NULL;
+}
@@ -0,0 +1,36 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdio.h>
+#include "sim.h"
+
+#define REPLAY_VERSION 2
+#define REPLAY_END 0xFF
+
+// file layout: "20GR", u16 version, u32 tick rate, u64 seed, u64 level hash (since version 2,
+// 0 = built-in board), then one record per input change:
+// varint ticks the previous input lasted + u8 input mask. A REPLAY_END mask closes the stream
+// and is followed by u64 total ticks and the u64 sim_checksum() of the final world
+typedef struct {
+    FILE* fp;
+    uint32_t tick_rate;
+    uint64_t seed;
+    uint64_t level_hash;
+    uint64_t ticks;
+    uint64_t run;
+    uint8_t mask;
+    uint8_t next_mask;
+    bool finished;
+    uint64_t total_ticks;
+    uint64_t checksum;
+} Replay;
+
+bool replay_record_open(Replay* r, const char* path, uint32_t tick_rate, uint64_t seed, uint64_t level_hash);
+void replay_record_tick(Replay* r, const SimInput* in);
+bool replay_record_close(Replay* r, uint64_t checksum);
+
+bool replay_play_open(Replay* r, const char* path);
+bool replay_play_tick(Replay* r, SimInput* in);
+void replay_play_close(Replay* r);
+
+#endif
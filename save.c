@@ -0,0 +1,185 @@
+#include "save.h"
+#include <stdio.h>
+#include <string.h>
+
+_Static_assert(sizeof(SaveHeader) == 16, "save header is written as is");
+_Static_assert(sizeof(SaveGame) == 32, "save record is written as is");
+
+static const char save_magic[4] = {'2', '0', 'G', 'S'};
+
+static bool write_file(const Saver* s, const SaveData* d) {
+    SaveHeader h = {.version = SAVE_VERSION, .size = sizeof(*d), .crc = SDL_crc32(0, d, sizeof(*d))};
+    memcpy(h.magic, save_magic, sizeof(h.magic));
+
+    SDL_IOStream* io = SDL_IOFromFile(s->temp_path, "wb");
+    if (io == NULL) {
+        printf("Error_save: %s\n", SDL_GetError());
+        return false;
+    }
+    bool ok = SDL_WriteIO(io, &h, sizeof(h)) == sizeof(h) && SDL_WriteIO(io, d, sizeof(*d)) == sizeof(*d)
+              && SDL_FlushIO(io);
+    if (!SDL_CloseIO(io)) ok = false;
+    // only replace the real save once the new one is completely on disk
+    if (!ok || !SDL_RenamePath(s->temp_path, s->path)) {
+        printf("Error_save: could not write %s: %s\n", s->path, SDL_GetError());
+        SDL_RemovePath(s->temp_path);
+        return false;
+    }
+    return true;
+}
+
+static int save_thread(void* data) {
+    Saver* s = data;
+    SaveData local;
+    SDL_LockMutex(s->lock);
+    for (;;) {
+        while (!s->dirty && !s->quit) SDL_WaitCondition(s->wake, s->lock);
+        if (!s->dirty) break;
+        local = s->pending;
+        s->dirty = false;
+        SDL_UnlockMutex(s->lock);
+        write_file(s, &local);
+        SDL_LockMutex(s->lock);
+    }
+    SDL_UnlockMutex(s->lock);
+    return 0;
+}
+
+static void clamp_game(SaveGame* g) {
+    if (g->score < 0 || g->score > SCORE_LIMIT) g->score = 0;
+    if (g->seconds < 0) g->seconds = 0;
+}
+
+// true when d was filled from a valid save file
+static bool read_file(const char* path, SaveData* d) {
+    size_t size;
+    uint8_t* data = SDL_LoadFile(path, &size);
+    if (data == NULL) return false;
+
+    SaveHeader h;
+    bool ok = size >= sizeof(h);
+    if (ok) {
+        memcpy(&h, data, sizeof(h));
+        ok = memcmp(h.magic, save_magic, sizeof(h.magic)) == 0 && h.version >= 1 && h.version <= SAVE_VERSION
+             && h.size <= sizeof(*d) && size - sizeof(h) >= h.size && SDL_crc32(0, data + sizeof(h), h.size) == h.crc;
+    }
+    if (ok) {
+        memset(d, 0, sizeof(*d));
+        memcpy(d, data + sizeof(h), h.size);
+        d->top_count = SDL_clamp(d->top_count, 0, SAVE_TOP_N);
+        d->recent_count = SDL_clamp(d->recent_count, 0, SAVE_RECENT);
+        if (d->recent_next < 0 || d->recent_next >= SAVE_RECENT) d->recent_next = 0;
+        for (int i = 0; i < SAVE_TOP_N; i++) clamp_game(&d->top[i]);
+        for (int i = 0; i < SAVE_RECENT; i++) clamp_game(&d->recent[i]);
+    } else {
+        printf("Error_save: %s is damaged, starting a new save\n", path);
+    }
+    SDL_free(data);
+    return ok;
+}
+
+// the pre-binary save was a single high score in a text file next to the executable
+static bool migrate_legacy(SaveData* d) {
+    FILE* fp = fopen(SAVE_LEGACY_FILE, "r");
+    if (!fp) return false;
+    int score;
+    bool ok = fscanf(fp, "%d", &score) == 1 && score > 0 && score <= SCORE_LIMIT;
+    fclose(fp);
+    if (ok) {
+        d->top[0] = (SaveGame) {.score = score};
+        d->top_count = 1;
+        printf("migrated high score %d from %s\n", score, SAVE_LEGACY_FILE);
+    }
+    return ok;
+}
+
+bool save_open(Saver* s, SaveData* d) {
+    memset(s, 0, sizeof(*s));
+    memset(d, 0, sizeof(*d));
+
+    char* dir = SDL_GetPrefPath("20g", "breakout");
+    if (dir == NULL) printf("Error_save: no pref path (%s), saving next to the game\n", SDL_GetError());
+    const char* base = dir ? dir : "";
+    size_t len = strlen(base) + strlen(SAVE_FILE_NAME) + 5;
+    s->path = SDL_malloc(len);
+    s->temp_path = SDL_malloc(len);
+    if (s->path == NULL || s->temp_path == NULL) {
+        SDL_free(dir);
+        save_close(s);
+        return false;
+    }
+    SDL_snprintf(s->path, len, "%s%s", base, SAVE_FILE_NAME);
+    SDL_snprintf(s->temp_path, len, "%s%s.tmp", base, SAVE_FILE_NAME);
+    SDL_free(dir);
+
+    bool migrated = false;
+    if (!read_file(s->path, d)) {
+        memset(d, 0, sizeof(*d));
+        migrated = migrate_legacy(d);
+    }
+
+    s->lock = SDL_CreateMutex();
+    s->wake = SDL_CreateCondition();
+    s->thread = (s->lock && s->wake) ? SDL_CreateThread(save_thread, "save", s) : NULL;
+    if (s->thread == NULL) {
+        printf("Error_save_thread: %s\n", SDL_GetError());
+        save_close(s);
+        return false;
+    }
+    if (migrated) save_write(s, d);
+    return true;
+}
+
+void save_write(Saver* s, const SaveData* d) {
+    if (s->thread == NULL) return;
+    SDL_LockMutex(s->lock);
+    s->pending = *d;
+    s->dirty = true;
+    SDL_SignalCondition(s->wake);
+    SDL_UnlockMutex(s->lock);
+}
+
+void save_close(Saver* s) {
+    if (s->thread != NULL) {
+        SDL_LockMutex(s->lock);
+        s->quit = true;
+        SDL_SignalCondition(s->wake);
+        SDL_UnlockMutex(s->lock);
+        SDL_WaitThread(s->thread, NULL);
+        s->thread = NULL;
+    }
+    if (s->wake) SDL_DestroyCondition(s->wake);
+    if (s->lock) SDL_DestroyMutex(s->lock);
+    s->wake = NULL;
+    s->lock = NULL;
+    SDL_free(s->path);
+    SDL_free(s->temp_path);
+    s->path = NULL;
+    s->temp_path = NULL;
+}
+
+void save_record_game(SaveData* d, const SaveGame* g) {
+    SaveTotals* t = &d->totals;
+    t->games_played += 1;
+    t->games_cleared += g->cleared ? 1 : 0;
+    t->points += (uint64_t)g->score;
+    t->seconds += (uint64_t)g->seconds;
+    t->lives_lost += (uint64_t)g->lives_lost;
+
+    d->recent[d->recent_next] = *g;
+    d->recent_next = (d->recent_next + 1) % SAVE_RECENT;
+    if (d->recent_count < SAVE_RECENT) d->recent_count += 1;
+
+    // insertion into the sorted leaderboard, ties keep the older game first
+    int at = d->top_count;
+    while (at > 0 && d->top[at - 1].score < g->score) at--;
+    if (at >= SAVE_TOP_N) return;
+    int last = d->top_count < SAVE_TOP_N ? d->top_count : SAVE_TOP_N - 1;
+    memmove(&d->top[at + 1], &d->top[at], sizeof(SaveGame) * (size_t)(last - at));
+    d->top[at] = *g;
+    if (d->top_count < SAVE_TOP_N) d->top_count += 1;
+}
+
+int save_best_score(const SaveData* d) {
+    return d->top_count > 0 ? d->top[0].score : 0;
+}
@@ -0,0 +1,74 @@
+#ifndef SAVE_H
+#define SAVE_H
+
+#include <SDL3/SDL.h>
+#include "sim.h"
+
+#define SAVE_VERSION 1
+#define SAVE_TOP_N 10
+#define SAVE_RECENT 32
+#define SAVE_FILE_NAME "save.bin"
+#define SAVE_LEGACY_FILE "save_file.txt"
+
+// file layout: SaveHeader then the SaveData bytes, little endian as the structs sit in memory.
+// size and crc (SDL_crc32) cover the SaveData part; a newer build may append fields, an older
+// record is read into the front of SaveData and the rest left zeroed
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t size;
+    uint32_t crc;
+} SaveHeader;
+
+typedef struct {
+    int32_t score;
+    int32_t seconds;        // game length from the sim Timer
+    int32_t lives_lost;
+    int32_t cleared;        // 1 when the board was emptied
+    uint64_t level_hash;    // 0 = built-in board
+    int64_t when;           // SDL_Time the game ended, 0 if unknown (migrated scores)
+} SaveGame;
+
+typedef struct {
+    uint32_t games_played;
+    uint32_t games_cleared;
+    uint64_t points;
+    uint64_t seconds;
+    uint64_t lives_lost;
+} SaveTotals;
+
+typedef struct {
+    SaveTotals totals;
+    int32_t top_count;
+    int32_t recent_count;
+    int32_t recent_next;        // ring position the next game goes to
+    int32_t reserved;
+    SaveGame top[SAVE_TOP_N];   // best scores, highest first
+    SaveGame recent[SAVE_RECENT];
+} SaveData;
+
+// Writes happen on a background thread: save_write() copies the record and returns, the thread
+// writes it to a temp file and renames that over the save, so a crash leaves the old or the new
+// file but never a truncated one. Requests made while a write is running collapse into one
+typedef struct {
+    char* path;
+    char* temp_path;
+    SDL_Thread* thread;
+    SDL_Mutex* lock;
+    SDL_Condition* wake;
+    SaveData pending;
+    bool dirty;
+    bool quit;
+} Saver;
+
+// loads (or migrates the old text high score into) d and starts the writer thread
+bool save_open(Saver* s, SaveData* d);
+void save_write(Saver* s, const SaveData* d);
+// flushes any pending write and stops the thread
+void save_close(Saver* s);
+
+void save_record_game(SaveData* d, const SaveGame* g);
+int save_best_score(const SaveData* d);
+
+#endif
@@ -0,0 +1,827 @@
+#include "sim.h"
+#include "level.h"
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+static const SimColor yellow = {187, 165, 59, 255};
+static const SimColor green = {99, 141, 91, 255};
+static const SimColor pink = {179, 100, 138, 255};
+static const SimColor red = {154, 78, 78, 255};
+static const SimColor grey = {195, 195, 195, 255};
+static const SimColor white = {220, 220, 220, 255};
+
+#define SIM_MAX_CONTACTS 8
+#define SIM_MAX_BRICK_HITS 4
+#define SIM_TOI_EPSILON 1e-5f
+#define SIM_SKIN 0.01f
+
+typedef enum {
+    CONTACT_NONE,
+    CONTACT_WALL,
+    CONTACT_TOP,
+    CONTACT_FLOOR,
+    CONTACT_PADDLE,
+    CONTACT_BRICK,
+} ContactKind;
+
+const SimParams sim_default_params = {
+    .red_points = RED_POINTS,
+    .pink_points = PINK_POINTS,
+    .green_points = GREEN_POINTS,
+    .yellow_points = YELLOW_POINTS,
+    .boost_hits = {4, 13},
+    .boost_speed = 0.25f,
+    .collision_angle = BLOCK_COLLISION_ANGLE,
+    .multiball_spawn = 2,
+    .multiball_chance = 0.0f,
+};
+
+_Static_assert(BRICK_MAX_COLS <= 64, "row_alive holds one bit per brick in a row");
+
+bool sim_rect_overlap(const SimRect* a, const SimRect* b) {
+    return a->x < b->x + b->w && a->x + a->w > b->x && a->y < b->y + b->h && a->y + a->h > b->y;
+}
+
+// cell geometry for a cols x rows board, laid out the way the original 14 x 8 wall was
+static void brick_field_layout(BrickField* f, int cols, int rows) {
+    int span = WIDTH - cols * BLOCK_X_OFFSET;
+    float gap = (float)(WIDTH - (float)cols * span / cols);
+    float cell_h = ((float)HEIGHT / 3) / (rows > BLOCK_COLS ? rows : BLOCK_COLS);
+
+    f->cols = cols;
+    f->rows = rows;
+    f->origin_x = (0.5f * gap) + BLOCK_X_OFFSET;
+    f->origin_y = HOTBAR_H + BLOCK_Y_OFFSET;
+    f->pitch_x = (float)span / cols;
+    f->pitch_y = cell_h + BLOCK_Y_OFFSET;
+
+    for (int i = 0; i < BRICK_CAPACITY; i++) {
+        // cells past the board sit far off screen so the SIMD kernel never reports them
+        f->x[i] = f->y[i] = -1e9f;
+        f->w[i] = f->h[i] = 0.0f;
+        f->hp[i] = f->start_hp[i] = 0;
+        f->type[i] = BRICK_EMPTY;
+        f->color[i] = (SimColor) {0, 0, 0, 0};
+        f->points[i] = 0;
+    }
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+            int i = y * cols + x;
+            f->x[i] = f->origin_x + (x * f->pitch_x);
+            f->y[i] = f->origin_y + (y * f->pitch_y);
+            f->w[i] = (float)span / cols - BLOCK_X_OFFSET;
+            f->h[i] = cell_h;
+        }
+    }
+}
+
+// snapshot the freshly filled cells as the board's starting state
+static void brick_field_finish(BrickField* f) {
+    f->breakable = 0;
+    f->max_score = 0;
+    f->worn = 0;
+    for (int y = 0; y < BRICK_MAX_ROWS; y++) {
+        f->start_alive[y] = 0;
+        f->row_worn[y] = 0;
+    }
+    for (int y = 0; y < f->rows; y++) {
+        for (int x = 0; x < f->cols; x++) {
+            int i = y * f->cols + x;
+            int type = f->type[i] & BRICK_TYPE_MASK;
+            if (type == BRICK_EMPTY) continue;
+            f->start_alive[y] |= 1ull << x;
+            if (f->start_hp[i] > 1) {
+                f->row_worn[y] |= 1ull << x;
+                f->worn += 1;
+            }
+            if (type == BRICK_SOLID) continue;
+            if (f->start_hp[i] == 0) f->start_hp[i] = 1;
+            f->breakable += 1;
+            f->max_score += f->points[i];
+        }
+    }
+    memcpy(f->row_alive, f->start_alive, sizeof(f->row_alive));
+    memcpy(f->hp, f->start_hp, sizeof(f->hp));
+}
+
+// the built-in 14 x 8 wall: two rows each of red, pink, green and yellow
+static void brick_field_classic(BrickField* f, const SimParams* p) {
+    brick_field_layout(f, BLOCK_ROWS, BLOCK_COLS);
+    f->level_hash = 0;
+    for (int y = 0; y < BLOCK_COLS; y++) {
+        for (int x = 0; x < BLOCK_ROWS; x++) {
+            int i = y * BLOCK_ROWS + x;
+            f->type[i] = BRICK_NORMAL;
+            f->start_hp[i] = 1;
+            switch (y) {
+                case 0:
+                case 1:
+                    f->type[i] |= BRICK_FLAG_FAST;
+                    f->color[i] = red;
+                    f->points[i] = p->red_points;
+                    break;
+                case 2:
+                case 3:
+                    f->type[i] |= BRICK_FLAG_FAST;
+                    f->color[i] = pink;
+                    f->points[i] = p->pink_points;
+                    break;
+                case 4:
+                case 5:
+                    f->color[i] = green;
+                    f->points[i] = p->green_points;
+                    break;
+                case 6:
+                case 7:
+                    f->color[i] = yellow;
+                    f->points[i] = p->yellow_points;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    brick_field_finish(f);
+}
+
+void sim_init(SimWorld* w) {
+    sim_init_params(w, &sim_default_params);
+}
+
+void sim_init_params(SimWorld* w, const SimParams* p) {
+    w->params = *p;
+    w->time = (Timer) {.minutes = 0, .seconds = 0, .elapsed = 0.0};
+    w->consecutive_hits = 0;
+    w->first_hit_pink_or_red = false;
+    w->first_hit_top_wall = false;
+    w->status = IN_MENU;
+    w->points = 0;
+    w->last_score = 0;
+    w->last_time = w->time;
+    w->last_lives = 0;
+    w->lives = MAX_LIVES;
+
+    w->player = (Player) {
+        .shape = (SimRect) {.x = (WIDTH * 0.5f) - (PADDLE_W * 0.5f), .y = HEIGHT - (2*PADDLE_H), .w = PADDLE_W, .h = PADDLE_H},
+        .move_speed = WIDTH * 0.6f,
+        .colour = grey,
+        .game_started = false,
+        .half_size = false,
+    };
+
+    w->balls[0] = (Ball) {
+        .shape = (SimRect) {
+            .x = (w->player.shape.x + (0.5f*w->player.shape.w)),
+            .y = (w->player.shape.y - BALL_SIZE),
+            .w = BALL_SIZE, .h = BALL_SIZE
+        },
+        .vel_y = -1.0f,
+        .move_speed = MIN_BALL_SPEED,
+        .speed_modifier = 0.9f,
+    };
+    w->balls[0].prev = w->balls[0].shape;
+    w->ball_count = 1;
+    sim_seed(w, 0);
+
+    brick_field_classic(&w->bricks, p);
+    w->brick_count = w->bricks.breakable;
+}
+
+// swap the board for a level's cells; the level's data is copied, the mapping can go away afterwards
+void sim_load_level(SimWorld* w, const Level* lv) {
+    BrickField* f = &w->bricks;
+    int cols = lv->header->cols;
+    int rows = lv->header->rows;
+    brick_field_layout(f, cols, rows);
+    f->level_hash = lv->header->hash;
+    for (int i = 0; i < cols * rows; i++) {
+        f->type[i] = lv->type[i];
+        f->start_hp[i] = lv->hp[i];
+        f->points[i] = lv->points[i];
+        f->color[i] = lv->palette[lv->colour[i] < lv->header->colour_count ? lv->colour[i] : 0];
+    }
+    brick_field_finish(f);
+    w->brick_count = f->breakable;
+}
+
+void sim_reset(SimWorld* w) {
+    w->time.minutes = 0;
+    w->time.seconds = 0;
+    w->time.elapsed = 0.0;
+
+    w->points = 0;
+    w->brick_count = w->bricks.breakable;
+    w->lives = MAX_LIVES;
+    w->player.half_size = false;
+    w->player.shape = (SimRect) {.x = (WIDTH * 0.5f) - (PADDLE_W * 0.5f), .y = HEIGHT - (2*PADDLE_H), .w = PADDLE_W, .h = PADDLE_H};
+    w->player.colour = white;
+    w->ball_count = 1;
+
+    memcpy(w->bricks.row_alive, w->bricks.start_alive, sizeof(w->bricks.row_alive));
+    memcpy(w->bricks.hp, w->bricks.start_hp, sizeof(w->bricks.hp));
+}
+
+static int grid_cell(float p, float origin, float pitch) {
+    return (int)floorf((p - origin) / pitch);
+}
+
+// per-ball scratch for one contact iteration
+typedef struct {
+    float remaining;
+    float dx, dy;
+    float toi;
+    ContactKind kind;
+    SimAxis axis;
+    int x0, x1, y0, y1;     // brick cells the sweep covers, y0 > y1 when none
+    float brick_toi;
+    SimAxis brick_axis;
+    int hit_count;
+    int hits[SIM_MAX_BRICK_HITS];
+    bool done;
+    bool dead;
+} BallContact;
+
+// lattice cells covered by the swept bounds of a
+static void swept_cells(const BrickField* f, const SimRect* a, float dx, float dy, BallContact* c) {
+    float min_x = fminf(a->x, a->x + dx), max_x = fmaxf(a->x, a->x + dx) + a->w;
+    float min_y = fminf(a->y, a->y + dy), max_y = fmaxf(a->y, a->y + dy) + a->h;
+    c->y0 = 0;
+    c->y1 = -1;
+
+    int y0 = grid_cell(min_y, f->origin_y, f->pitch_y);
+    int y1 = grid_cell(max_y, f->origin_y, f->pitch_y);
+    if (y1 < 0 || y0 >= f->rows) return;
+    int x0 = grid_cell(min_x, f->origin_x, f->pitch_x);
+    int x1 = grid_cell(max_x, f->origin_x, f->pitch_x);
+    if (x1 < 0 || x0 >= f->cols) return;
+
+    c->y0 = y0 < 0 ? 0 : y0;
+    c->y1 = y1 >= f->rows ? f->rows - 1 : y1;
+    c->x0 = x0 < 0 ? 0 : x0;
+    c->x1 = x1 >= f->cols ? f->cols - 1 : x1;
+}
+
+// One pass over the brick rows for every ball still moving: each live row is visited once and
+// swept against the balls whose paths cover it. Per ball this finds the earliest brick(s) hit
+// before its other contacts, visiting cells in the same row-major order as a per-ball query
+static void sweep_bricks(const SimWorld* w, const Ball* balls, BallContact* contacts, int count) {
+    const BrickField* f = &w->bricks;
+    float lane_toi[BRICK_MAX_COLS];
+    uint8_t lane_axis[BRICK_MAX_COLS];
+
+    // only the band of rows some ball actually covers
+    int row_min = f->rows, row_max = -1;
+    for (int b = 0; b < count; b++) {
+        if (contacts[b].done || contacts[b].y0 > contacts[b].y1) continue;
+        if (contacts[b].y0 < row_min) row_min = contacts[b].y0;
+        if (contacts[b].y1 > row_max) row_max = contacts[b].y1;
+    }
+
+    for (int y = row_min; y <= row_max; y++) {
+        if (f->row_alive[y] == 0) continue;
+        for (int b = 0; b < count; b++) {
+            BallContact* c = &contacts[b];
+            if (c->done || y < c->y0 || y > c->y1) continue;
+            uint64_t alive = f->row_alive[y] >> c->x0;
+            if (alive == 0) continue;
+            // the covered cells of a row are contiguous in the SoA arrays: sweep them in one go
+            int first = y * f->cols + c->x0;
+            brick_sweep(f, first, c->x1 - c->x0 + 1, &balls[b].shape, c->dx, c->dy, lane_toi, lane_axis);
+            for (int x = 0; x <= c->x1 - c->x0; x++) {
+                float t = lane_toi[x];
+                if (((alive >> x) & 1u) == 0 || t >= c->toi) continue;
+                if (t < c->brick_toi - SIM_TOI_EPSILON) {
+                    c->brick_toi = t;
+                    c->brick_axis = (SimAxis)lane_axis[x];
+                    c->hit_count = 0;
+                }
+                if (t <= c->brick_toi + SIM_TOI_EPSILON && c->hit_count < SIM_MAX_BRICK_HITS) {
+                    c->hits[c->hit_count++] = first + x;
+                }
+            }
+        }
+    }
+}
+
+// earliest live brick box a hits moving by (dx, dy), -1 for none. The same query a ball's
+// contact step makes, for tools that want to look at the collision path on its own
+int sim_brick_query(const SimWorld* w, const SimRect* a, float dx, float dy, float* toi, SimAxis* axis) {
+    Ball ball = {.shape = *a};
+    BallContact c = {.dx = dx, .dy = dy, .toi = INFINITY, .brick_toi = INFINITY};
+    swept_cells(&w->bricks, a, dx, dy, &c);
+    sweep_bricks(w, &ball, &c, 1);
+    if (c.hit_count == 0) return -1;
+    *toi = c.brick_toi;
+    *axis = c.brick_axis;
+    return c.hits[0];
+}
+
+static void ball_velocity(const Ball* b, float* vx, float* vy) {
+    float dynamic_move_x = b->speed_modifier * (b->move_speed + ((1.0f - fabsf(b->vel_x)) * b->move_speed));
+    float dynamic_move_y = b->speed_modifier * (b->move_speed * (1.0f + (1.0f - fabs(b->vel_x))));
+    *vx = b->vel_x * dynamic_move_x;
+    *vy = b->vel_y * dynamic_move_y;
+}
+
+// xorshift64*, the only source of randomness in the sim; seeded by sim_seed() and carried in replays
+static uint32_t sim_rand(SimWorld* w) {
+    w->rng ^= w->rng >> 12;
+    w->rng ^= w->rng << 25;
+    w->rng ^= w->rng >> 27;
+    return (uint32_t)((w->rng * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+void sim_seed(SimWorld* w, uint64_t seed) {
+    w->rng = seed ? seed : 0x9E3779B97F4A7C15ull;
+}
+
+bool sim_spawn_ball(SimWorld* w, const Ball* from, float vel_x, float vel_y) {
+    if (w->ball_count >= SIM_MAX_BALLS) return false;
+    Ball* b = &w->balls[w->ball_count++];
+    *b = *from;
+    b->vel_x = vel_x;
+    b->vel_y = vel_y;
+    b->prev = b->shape;
+    return true;
+}
+
+// multiball power-up: new balls fan out upwards from the one that broke the brick
+static void spawn_multiball(SimWorld* w, int ball) {
+    for (int i = 0; i < w->params.multiball_spawn; i++) {
+        float spread = 0.2f + 0.6f * ((float)sim_rand(w) / 4294967296.0f);
+        Ball from = w->balls[ball];
+        if (!sim_spawn_ball(w, &from, (i & 1) ? spread : -spread, -1.0f)) break;
+    }
+}
+
+static void hit_brick(SimWorld* w, int ball, int i) {
+    const SimParams* p = &w->params;
+    BrickField* f = &w->bricks;
+    if ((f->type[i] & BRICK_TYPE_MASK) == BRICK_SOLID) return;
+
+    w->consecutive_hits += 1;
+    if (w->consecutive_hits == p->boost_hits[0] || w->consecutive_hits == p->boost_hits[1]) {
+        w->consecutive_hits += 1;
+        w->balls[ball].speed_modifier = w->balls[ball].speed_modifier + p->boost_speed;
+    }
+    if ((f->type[i] & BRICK_FLAG_FAST) && !w->first_hit_pink_or_red) {
+        w->first_hit_pink_or_red = true;
+    }
+    if (f->hp[i] > 1) {
+        f->hp[i] -= 1;
+        return;
+    }
+    f->hp[i] = 0;
+    f->row_alive[i / f->cols] &= ~(1ull << (i % f->cols));
+    w->brick_count -=1;
+    w->points += f->points[i];
+
+    // the random drop only rolls when enabled, so boards without it never touch the rng
+    if ((f->type[i] & BRICK_FLAG_MULTI) || (p->multiball_chance > 0.0f && (float)sim_rand(w) / 4294967296.0f < p->multiball_chance)) {
+        spawn_multiball(w, ball);
+    }
+}
+
+uint32_t sim_step(SimWorld* w, const SimInput* in, double dt) {
+    uint32_t events = 0;
+
+    if (w->status == IN_MENU) {
+        if (in->menu_yes) {
+            w->status = RESET_ROUND;
+        } else if (in->menu_no) {
+            events |= SIM_EVENT_QUIT;
+        }
+        return events;
+    }
+
+    {
+        //::update timer
+        if (w->player.game_started) {
+            w->time.elapsed += dt;
+            if (w->time.elapsed >= 1.0) {
+                w->time.elapsed -= 1.0;
+                w->time.seconds += 1;
+                if (w->time.seconds >= 60) {
+                    w->time.seconds = 0;
+                    w->time.minutes += 1;
+                }
+                events |= SIM_EVENT_TIME;
+            }
+        }
+    }
+
+    {
+        //::update ball
+        for (int i = 0; i < w->ball_count; i++) {
+            Ball* ball = &w->balls[i];
+            ball->prev = ball->shape;
+            if (w->consecutive_hits == 0 || w->status == RESET_ROUND) {
+                ball->speed_modifier = 0.9f;
+            }
+            if (w->first_hit_pink_or_red) {
+                ball->move_speed = MIN_BALL_SPEED + 50;
+            }
+        }
+
+        if (w->status == RESET_ROUND) {
+            w->first_hit_top_wall = false;
+            w->first_hit_pink_or_red = false;
+            w->consecutive_hits = 0;
+            w->ball_count = 1;
+            Ball* ball = &w->balls[0];
+            ball->shape.x = w->player.shape.x + (0.5f*w->player.shape.w);
+            ball->shape.y = w->player.shape.y - BALL_SIZE;
+            ball->vel_y = -1.0f;
+            ball->vel_x = 0.0f;
+            ball->move_speed = MIN_BALL_SPEED;
+        } else {
+            // every ball advances to its earliest contact, responds, and carries on with the time left
+            // over; all balls take each step together so the brick field is walked once per step
+            int count = w->ball_count;
+            int drained = 0;
+            BallContact contacts[SIM_MAX_BALLS];
+            for (int i = 0; i < count; i++) {
+                Ball* ball = &w->balls[i];
+                if (ball->vel_x == 0.0f || ball->vel_x == -0.0f) ball->vel_x = 0.003f;
+                contacts[i].remaining = (float)dt;
+                contacts[i].done = false;
+                contacts[i].dead = false;
+            }
+
+            for (int contact = 0; contact < SIM_MAX_CONTACTS && w->status != RESET_ROUND; contact++) {
+                int active = 0;
+                float floor_y = w->player.shape.y + (0.5f * w->player.shape.h);
+                for (int i = 0; i < count; i++) {
+                    BallContact* c = &contacts[i];
+                    Ball* ball = &w->balls[i];
+                    if (c->done || c->remaining <= 0.0f) {
+                        c->done = true;
+                        continue;
+                    }
+                    active += 1;
+
+                    float vx, vy;
+                    ball_velocity(ball, &vx, &vy);
+                    float dx = vx * c->remaining;
+                    float dy = vy * c->remaining;
+                    c->dx = dx;
+                    c->dy = dy;
+                    c->kind = CONTACT_NONE;
+                    c->axis = AXIS_Y;
+                    c->toi = 1.0f;
+                    float t;
+
+                    if (dx < 0.0f && ball->shape.x + dx <= 0.0f) {
+                        c->toi = fmaxf(0.0f, -ball->shape.x / dx);
+                        c->kind = CONTACT_WALL;
+                    } else if (dx > 0.0f && ball->shape.x + BALL_SIZE + dx > WIDTH) {
+                        c->toi = fmaxf(0.0f, (WIDTH - BALL_SIZE - ball->shape.x) / dx);
+                        c->kind = CONTACT_WALL;
+                    }
+                    if (dy < 0.0f && ball->shape.y + dy <= HOTBAR_H) {
+                        t = fmaxf(0.0f, (HOTBAR_H - ball->shape.y) / dy);
+                        if (t < c->toi) {
+                            c->toi = t;
+                            c->kind = CONTACT_TOP;
+                        }
+                    }
+                    if (dy > 0.0f && ball->shape.y + dy > floor_y) {
+                        t = fmaxf(0.0f, (floor_y - ball->shape.y) / dy);
+                        if (t < c->toi) {
+                            c->toi = t;
+                            c->kind = CONTACT_FLOOR;
+                        }
+                    }
+                    SimAxis hit_axis;
+                    if (dy > 0.0f && sim_sweep_rect(&ball->shape, dx, dy, &w->player.shape, &t, &hit_axis) && t < c->toi) {
+                        c->toi = t;
+                        c->axis = hit_axis;
+                        c->kind = CONTACT_PADDLE;
+                    }
+                    c->brick_toi = INFINITY;
+                    c->hit_count = 0;
+                    swept_cells(&w->bricks, &ball->shape, dx, dy, c);
+                }
+                if (active == 0) break;
+
+                sweep_bricks(w, w->balls, contacts, count);
+
+                for (int i = 0; i < count && w->status != RESET_ROUND; i++) {
+                    BallContact* c = &contacts[i];
+                    Ball* ball = &w->balls[i];
+                    if (c->done) continue;
+
+                    if (c->hit_count > 0 && c->brick_toi < c->toi) {
+                        // a ball earlier in this step may already have broken these; if so look again next step
+                        int still_alive = 0;
+                        for (int h = 0; h < c->hit_count; h++) {
+                            if (brick_alive(&w->bricks, c->hits[h])) c->hits[still_alive++] = c->hits[h];
+                        }
+                        if (still_alive == 0) continue;
+                        c->hit_count = still_alive;
+                        c->toi = c->brick_toi;
+                        c->axis = c->brick_axis;
+                        c->kind = CONTACT_BRICK;
+                    }
+
+                    float dx = c->dx, dy = c->dy;
+                    ContactKind kind = c->kind;
+                    SimAxis axis = c->axis;
+                    ball->shape.x += dx * c->toi;
+                    ball->shape.y += dy * c->toi;
+                    c->remaining *= (1.0f - c->toi);
+                    if (kind == CONTACT_NONE) {
+                        c->done = true;
+                        continue;
+                    }
+
+                    if (kind == CONTACT_PADDLE || kind == CONTACT_BRICK) {
+                        if (axis == AXIS_X) ball->shape.x -= (dx > 0.0f) ? SIM_SKIN : -SIM_SKIN;
+                        else ball->shape.y -= (dy > 0.0f) ? SIM_SKIN : -SIM_SKIN;
+                    }
+
+                    if (kind == CONTACT_WALL) {
+                        ball->vel_x *= -1;
+                    } else if (kind == CONTACT_TOP) {
+                        w->first_hit_top_wall = true;
+                        ball->vel_y *= -1;
+                    } else if (kind == CONTACT_FLOOR) {
+                        c->done = true;
+                        // only the last ball in play costs a life, extra balls just leave; ball_count
+                        // includes balls a multiball brick released earlier in this same step
+                        if (w->ball_count - drained > 1) {
+                            c->dead = true;
+                            drained += 1;
+                            continue;
+                        }
+                        w->lives -=1;
+                        events |= SIM_EVENT_LIFE_LOST;
+                        w->status = RESET_ROUND;
+                    } else if (kind == CONTACT_PADDLE) {
+                        events |= SIM_EVENT_PADDLE;
+                        float mid_collider = ball->shape.x + (0.5f * ball->shape.w);
+                        float mid_paddle = w->player.shape.x + (0.5f * w->player.shape.w);
+                        float end_paddle = w->player.shape.x + w->player.shape.w;
+                        float half_paddle_size = PADDLE_W * 0.5f;
+
+                        if (mid_collider > mid_paddle) {
+                            float relative_pos = half_paddle_size  - (end_paddle - mid_collider);
+                            ball->vel_x = relative_pos / 100.0f;
+                        } else if (ball->shape.x < w->player.shape.x + (0.5f * w->player.shape.w)) {
+                            float relative_pos = half_paddle_size - (mid_collider - w->player.shape.x);
+                            ball->vel_x = -1 * (relative_pos / 100.0f);
+                        }
+                        ball->vel_y = -1;
+                    } else if (kind == CONTACT_BRICK) {
+                        // every brick touched at the same instant takes a hit, the ball bounces once
+                        for (int h = 0; h < c->hit_count; h++) {
+                            hit_brick(w, i, c->hits[h]);
+                        }
+                        float angle = w->params.collision_angle;
+                        if (axis == AXIS_X) {
+                            ball->vel_x = (ball->vel_x >= 0.0f) ? -angle : angle;
+                        } else {
+                            ball->vel_x = (ball->vel_x >= 0.0f) ? angle : -angle;
+                            ball->vel_y *= -1;
+                        }
+                        events |= SIM_EVENT_SCORE;
+                    }
+                }
+            }
+
+            // swap-remove the balls that left through the floor; balls spawned this step sit past count
+            for (int i = count - 1; i >= 0; i--) {
+                if (contacts[i].dead) w->balls[i] = w->balls[--w->ball_count];
+            }
+        }
+    }
+
+    // only after the ball has been parked on the paddle for this round
+    if (in->serve && w->status == RESET_ROUND) {
+        w->status = IN_PLAY;
+        w->player.game_started = true;
+    }
+
+    {
+        //::update player
+        if (w->first_hit_top_wall && !w->player.half_size) {
+            w->player.half_size = true;
+            w->player.shape.w *= 0.5f;
+            w->player.shape.x += 0.5f * PADDLE_W;
+        }
+        if (in->move_left && !in->move_right) w->player.velocity = -1;
+        else if (in->move_right && !in->move_left) w->player.velocity = 1;
+        else w->player.velocity = 0;
+
+        float new_x = w->player.shape.x + (w->player.velocity * w->player.move_speed * dt);
+        if (new_x < 0 || new_x + w->player.shape.w > WIDTH) new_x = w->player.shape.x;
+        w->player.shape.x = new_x;
+    }
+
+    //::update state
+    if (w->brick_count <= 0 || w->lives <= 0) {
+        w->player.colour = (w->brick_count <= 0) ? green : red;
+        w->last_score = w->points;
+        w->last_time = w->time;
+        w->last_lives = w->lives;
+        sim_reset(w);
+        w->status = IN_MENU;
+        events |= SIM_EVENT_GAME_OVER;
+    }
+
+    return events;
+}
+
+static uint64_t hash_bytes(uint64_t h, const void* data, size_t n) {
+    const uint8_t* p = data;
+    for (size_t i = 0; i < n; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+static uint64_t hash_float(uint64_t h, float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return hash_bytes(h, &bits, sizeof(bits));
+}
+
+static uint64_t hash_int(uint64_t h, int64_t v) {
+    return hash_bytes(h, &v, sizeof(v));
+}
+
+static uint64_t hash_rect(uint64_t h, const SimRect* r) {
+    h = hash_float(h, r->x);
+    h = hash_float(h, r->y);
+    h = hash_float(h, r->w);
+    return hash_float(h, r->h);
+}
+
+static uint64_t hash_ball(uint64_t h, const Ball* b) {
+    h = hash_rect(h, &b->shape);
+    h = hash_float(h, b->vel_x);
+    h = hash_float(h, b->vel_y);
+    h = hash_float(h, b->move_speed);
+    return hash_float(h, b->speed_modifier);
+}
+
+// FNV-1a over every simulated field (not the raw struct, whose padding is unspecified)
+uint64_t sim_checksum(const SimWorld* w) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    h = hash_rect(h, &w->player.shape);
+    h = hash_float(h, w->player.velocity);
+    h = hash_int(h, w->player.game_started);
+    h = hash_int(h, w->player.half_size);
+    h = hash_ball(h, &w->balls[0]);
+    h = hash_int(h, w->status);
+    h = hash_bytes(h, w->bricks.row_alive, sizeof(uint64_t) * w->bricks.rows);
+    // damage on bricks still standing; always zero on one-hit boards, so older replays still verify
+    int wear = 0;
+    for (int i = 0; i < w->bricks.rows * w->bricks.cols; i++) {
+        if (brick_alive(&w->bricks, i)) wear += w->bricks.start_hp[i] - w->bricks.hp[i];
+    }
+    if (wear != 0) h = hash_int(h, wear);
+    h = hash_int(h, w->points);
+    h = hash_int(h, w->lives);
+    h = hash_int(h, w->brick_count);
+    h = hash_int(h, w->consecutive_hits);
+    h = hash_int(h, w->first_hit_pink_or_red);
+    h = hash_int(h, w->first_hit_top_wall);
+    h = hash_int(h, w->time.minutes);
+    h = hash_int(h, w->time.seconds);
+    h = hash_bytes(h, &w->time.elapsed, sizeof(w->time.elapsed));
+    h = hash_int(h, w->last_score);
+    // extra balls only exist in multiball play, leave single-ball hashes as they always were
+    if (w->ball_count > 1) {
+        h = hash_int(h, w->ball_count);
+        for (int i = 1; i < w->ball_count; i++) h = hash_ball(h, &w->balls[i]);
+    }
+    return h;
+}
+
+//::snapshots
+
+#define SNAP_PINK_OR_RED (1u << 0)
+#define SNAP_TOP_WALL    (1u << 1)
+#define SNAP_STARTED     (1u << 2)
+#define SNAP_HALF_SIZE   (1u << 3)
+
+size_t sim_snapshot_size(const SimWorld* w) {
+    const BrickField* f = &w->bricks;
+    return sizeof(SimSnapshot) + sizeof(SnapshotBall) * (size_t)w->ball_count + (size_t)(f->rows * ((f->cols + 7) / 8))
+           + (size_t)f->worn;
+}
+
+size_t sim_snapshot_save(const SimWorld* w, void* out) {
+    const BrickField* f = &w->bricks;
+    uint8_t* p = out;
+    SimSnapshot s = {
+        .rng = w->rng,
+        .elapsed = w->time.elapsed,
+        .points = w->points,
+        .brick_count = w->brick_count,
+        .consecutive_hits = w->consecutive_hits,
+        .last_score = w->last_score,
+        .paddle_x = w->player.shape.x,
+        .paddle_velocity = w->player.velocity,
+        .paddle_colour = w->player.colour,
+        .lives = (int16_t)w->lives,
+        .minutes = (int16_t)w->time.minutes,
+        .seconds = (int16_t)w->time.seconds,
+        .ball_count = (uint16_t)w->ball_count,
+        .status = (uint8_t)w->status,
+        .flags = (uint8_t)((w->first_hit_pink_or_red ? SNAP_PINK_OR_RED : 0) | (w->first_hit_top_wall ? SNAP_TOP_WALL : 0)
+                           | (w->player.game_started ? SNAP_STARTED : 0) | (w->player.half_size ? SNAP_HALF_SIZE : 0)),
+    };
+    memcpy(p, &s, sizeof(s));
+    p += sizeof(s);
+
+    for (int i = 0; i < w->ball_count; i++) {
+        const Ball* b = &w->balls[i];
+        SnapshotBall sb = {b->shape.x, b->shape.y, b->vel_x, b->vel_y, b->move_speed, b->speed_modifier};
+        memcpy(p, &sb, sizeof(sb));
+        p += sizeof(sb);
+    }
+
+    // each row's alive bits, then hp for the worn cells only; one-hit cells have
+    // hp = alive ? start_hp : 0 so they need nothing more
+    int row_bytes = (f->cols + 7) / 8;
+    for (int y = 0; y < f->rows; y++) {
+        uint64_t alive = f->row_alive[y];
+        for (int b = 0; b < row_bytes; b++) *p++ = (uint8_t)(alive >> (8 * b));
+    }
+    for (int y = 0; y < f->rows; y++) {
+        uint64_t worn = f->row_worn[y];
+        for (int i = y * f->cols; worn != 0; i++, worn >>= 1) {
+            if (worn & 1u) *p++ = f->hp[i];
+        }
+    }
+    return (size_t)(p - (uint8_t*)out);
+}
+
+bool sim_snapshot_restore(SimWorld* w, const void* in, size_t size) {
+    BrickField* f = &w->bricks;
+    const uint8_t* p = in;
+    SimSnapshot s;
+    if (size < sizeof(s)) return false;
+    memcpy(&s, p, sizeof(s));
+    int row_bytes = (f->cols + 7) / 8;
+    if (s.ball_count < 1 || s.ball_count > SIM_MAX_BALLS
+        || size != sizeof(s) + sizeof(SnapshotBall) * s.ball_count + (size_t)(f->rows * row_bytes) + (size_t)f->worn) {
+        return false;
+    }
+    p += sizeof(s);
+
+    w->rng = s.rng;
+    w->time.elapsed = s.elapsed;
+    w->time.minutes = s.minutes;
+    w->time.seconds = s.seconds;
+    w->points = s.points;
+    w->brick_count = s.brick_count;
+    w->consecutive_hits = s.consecutive_hits;
+    w->last_score = s.last_score;
+    w->lives = s.lives;
+    w->status = (PlayStatus)s.status;
+    w->first_hit_pink_or_red = s.flags & SNAP_PINK_OR_RED;
+    w->first_hit_top_wall = s.flags & SNAP_TOP_WALL;
+    w->player.game_started = s.flags & SNAP_STARTED;
+    w->player.half_size = s.flags & SNAP_HALF_SIZE;
+    w->player.shape.x = s.paddle_x;
+    w->player.shape.w = w->player.half_size ? (float)PADDLE_W * 0.5f : (float)PADDLE_W;
+    w->player.velocity = s.paddle_velocity;
+    w->player.colour = s.paddle_colour;
+
+    w->ball_count = s.ball_count;
+    for (int i = 0; i < w->ball_count; i++) {
+        SnapshotBall sb;
+        memcpy(&sb, p, sizeof(sb));
+        p += sizeof(sb);
+        Ball* b = &w->balls[i];
+        b->shape = (SimRect) {sb.x, sb.y, BALL_SIZE, BALL_SIZE};
+        b->prev = b->shape;
+        b->vel_x = sb.vel_x;
+        b->vel_y = sb.vel_y;
+        b->move_speed = sb.move_speed;
+        b->speed_modifier = sb.speed_modifier;
+    }
+
+    // only the cells that broke or came back since the snapshot change hp, worn cells are restored after
+    for (int y = 0; y < f->rows; y++) {
+        uint64_t alive = 0;
+        for (int b = 0; b < row_bytes; b++) alive |= (uint64_t)*p++ << (8 * b);
+        uint64_t changed = alive ^ f->row_alive[y];
+        f->row_alive[y] = alive;
+        for (int i = y * f->cols; changed != 0; i++, changed >>= 1, alive >>= 1) {
+            if (changed & 1u) f->hp[i] = (alive & 1u) ? f->start_hp[i] : 0;
+        }
+    }
+    for (int y = 0; y < f->rows; y++) {
+        uint64_t worn = f->row_worn[y];
+        for (int i = y * f->cols; worn != 0; i++, worn >>= 1) {
+            if (worn & 1u) f->hp[i] = *p++;
+        }
+    }
+    return true;
+}
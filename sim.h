@@ -0,0 +1,244 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define WIDTH 960
+#define HEIGHT 700
+
+#define PADDLE_W WIDTH * 0.18
+#define PADDLE_H HEIGHT * 0.03
+
+#define BALL_SIZE 10
+#define MIN_BALL_SPEED HEIGHT * 0.5
+
+#define BLOCK_COLS 8
+#define BLOCK_ROWS 14
+#define BLOCK_X_OFFSET 2
+#define BLOCK_Y_OFFSET 2
+#define BLOCK_W (WIDTH - BLOCK_ROWS * BLOCK_X_OFFSET) / (BLOCK_ROWS)
+#define BLOCK_H ((float)HEIGHT / 3) / (BLOCK_COLS)
+#define BLOCK_W_GAP (float) (WIDTH - ((float)BLOCK_ROWS * BLOCK_W))
+#define BLOCK_COLLISION_ANGLE 0.3f
+#define RED_POINTS 7
+#define PINK_POINTS 5
+#define GREEN_POINTS 3
+#define YELLOW_POINTS 1
+
+#define HOTBAR_H 40
+#define MAX_LIVES 3
+#define MAX_SCORE (2 * BLOCK_ROWS) * (RED_POINTS + PINK_POINTS + GREEN_POINTS + YELLOW_POINTS)
+// no level can score more than this, used to sanity check saved scores
+#define SCORE_LIMIT (BRICK_MAX_COLS * BRICK_MAX_ROWS * 255)
+
+// sim_step() result flags, so the caller can react without the sim touching SDL
+#define SIM_EVENT_TIME      (1u << 0)
+#define SIM_EVENT_LIFE_LOST (1u << 1)
+#define SIM_EVENT_SCORE     (1u << 2)
+#define SIM_EVENT_GAME_OVER (1u << 3)
+#define SIM_EVENT_QUIT      (1u << 4)
+#define SIM_EVENT_PADDLE    (1u << 5)   // a ball bounced off the paddle
+
+typedef struct {
+    float x, y, w, h;
+} SimRect;
+
+typedef enum {
+    AXIS_X,
+    AXIS_Y,
+} SimAxis;
+
+typedef struct {
+    uint8_t r, g, b, a;
+} SimColor;
+
+typedef enum {
+    IN_MENU,
+    RESET_ROUND,
+    GAME_OVER,
+    IN_PLAY,
+} PlayStatus;
+
+typedef struct {
+    int minutes;
+    int seconds;
+    double elapsed;
+} Timer;
+
+typedef struct {
+    SimRect shape;
+    SimColor colour;
+    float velocity;
+    float move_speed;
+    bool game_started;
+    bool half_size;
+} Player;
+
+typedef struct {
+    SimRect shape;
+    SimRect prev;   // shape at the start of the last tick, for render interpolation
+    float vel_x;
+    float vel_y;
+    float move_speed;
+    float speed_modifier;
+} Ball;
+
+#define SIM_MAX_BALLS 512
+
+#define BRICK_MAX_COLS 64
+#define BRICK_MAX_ROWS 32
+#define MAX_BRICKS (BRICK_MAX_COLS * BRICK_MAX_ROWS)
+#define BRICK_LANES 8
+#define BRICK_CAPACITY (((MAX_BRICKS) + BRICK_LANES - 1) / BRICK_LANES * BRICK_LANES)
+
+// low bits of a cell's type byte, BRICK_FLAG_FAST marks bricks whose first hit speeds the ball up,
+// BRICK_FLAG_MULTI bricks release extra balls when broken
+#define BRICK_EMPTY 0
+#define BRICK_NORMAL 1
+#define BRICK_SOLID 2
+#define BRICK_TYPE_MASK 0x0F
+#define BRICK_FLAG_FAST 0x80
+#define BRICK_FLAG_MULTI 0x40
+
+// structure-of-arrays brick storage for a cols x rows board, index = row * cols + column.
+// The collision path only touches the geometry arrays and the per-row alive bits; the
+// rest is read when a brick is drawn or hit. start_* hold the board as loaded, for resets;
+// row_worn marks the cells that start with more than 1 hp, which snapshots store hp for
+typedef struct {
+    int cols;
+    int rows;
+    float origin_x;
+    float origin_y;
+    float pitch_x;
+    float pitch_y;
+    int breakable;
+    int max_score;
+    uint64_t level_hash;
+    float x[BRICK_CAPACITY];
+    float y[BRICK_CAPACITY];
+    float w[BRICK_CAPACITY];
+    float h[BRICK_CAPACITY];
+    uint64_t row_alive[BRICK_MAX_ROWS];
+    uint8_t hp[BRICK_CAPACITY];
+    uint8_t type[BRICK_CAPACITY];
+    SimColor color[BRICK_CAPACITY];
+    int points[BRICK_CAPACITY];
+    uint64_t start_alive[BRICK_MAX_ROWS];
+    uint8_t start_hp[BRICK_CAPACITY];
+    uint64_t row_worn[BRICK_MAX_ROWS];
+    int worn;
+} BrickField;
+
+// tunable scoring/difficulty knobs, defaults mirror the macros above
+typedef struct {
+    int red_points;
+    int pink_points;
+    int green_points;
+    int yellow_points;
+    int boost_hits[2];      // consecutive hits at which the ball speeds up
+    float boost_speed;      // added to speed_modifier at each boost
+    float collision_angle;  // |vel_x| after bouncing off a brick
+    int multiball_spawn;    // balls released by a multiball brick
+    float multiball_chance; // chance any broken brick acts as a multiball brick
+} SimParams;
+
+extern const SimParams sim_default_params;
+
+// held keys stay set between ticks; serve/menu_* are edges the caller clears once consumed
+typedef struct {
+    bool move_left;
+    bool move_right;
+    bool serve;
+    bool menu_yes;
+    bool menu_no;
+} SimInput;
+
+typedef struct {
+    Player player;
+    Ball balls[SIM_MAX_BALLS];  // live balls are [0, ball_count), removed by swapping in the last
+    int ball_count;
+    PlayStatus status;
+    BrickField bricks;
+    int points;
+    int lives;
+    int brick_count;
+    int consecutive_hits;
+    bool first_hit_pink_or_red;
+    bool first_hit_top_wall;
+    Timer time;
+    int last_score;
+    Timer last_time;    // clock and lives the last game ended with, sim_reset() clears the live ones
+    int last_lives;
+    SimParams params;
+    uint64_t rng;
+} SimWorld;
+
+// Fixed part of a snapshot, followed by ball_count SnapshotBalls, each row's alive bits in
+// (cols + 7) / 8 little-endian bytes, and one hp byte for each row_worn cell. Everything else
+// (geometry, colours, params, start_* board) is fixed once a level is loaded, so a snapshot
+// only restores into the world it was taken from. Classic board, one ball: 96 bytes
+typedef struct {
+    uint64_t rng;
+    double elapsed;
+    int32_t points;
+    int32_t brick_count;
+    int32_t consecutive_hits;
+    int32_t last_score;
+    float paddle_x;
+    float paddle_velocity;
+    SimColor paddle_colour;
+    int16_t lives;
+    int16_t minutes;
+    int16_t seconds;
+    uint16_t ball_count;
+    uint8_t status;
+    uint8_t flags;
+} SimSnapshot;
+
+typedef struct {
+    float x, y;
+    float vel_x, vel_y;
+    float move_speed;
+    float speed_modifier;
+} SnapshotBall;
+
+void sim_init(SimWorld* w);
+void sim_init_params(SimWorld* w, const SimParams* p);
+void sim_reset(SimWorld* w);
+void sim_seed(SimWorld* w, uint64_t seed);
+bool sim_spawn_ball(SimWorld* w, const Ball* from, float vel_x, float vel_y);
+struct Level;
+void sim_load_level(SimWorld* w, const struct Level* lv);
+uint32_t sim_step(SimWorld* w, const SimInput* in, double dt);
+bool sim_rect_overlap(const SimRect* a, const SimRect* b);
+uint64_t sim_checksum(const SimWorld* w);
+size_t sim_snapshot_size(const SimWorld* w);
+size_t sim_snapshot_save(const SimWorld* w, void* out);
+bool sim_snapshot_restore(SimWorld* w, const void* in, size_t size);
+int sim_brick_query(const SimWorld* w, const SimRect* a, float dx, float dy, float* toi, SimAxis* axis);
+
+// one bit per SimInput field, the on-disk and on-wire form of a tick's input
+static inline uint8_t sim_input_to_mask(const SimInput* in) {
+    return (uint8_t)((in->move_left << 0) | (in->move_right << 1) | (in->serve << 2) | (in->menu_yes << 3) | (in->menu_no << 4));
+}
+
+static inline SimInput sim_mask_to_input(uint8_t mask) {
+    return (SimInput) {
+        .move_left = mask & (1u << 0),
+        .move_right = mask & (1u << 1),
+        .serve = mask & (1u << 2),
+        .menu_yes = mask & (1u << 3),
+        .menu_no = mask & (1u << 4),
+    };
+}
+
+static inline bool brick_alive(const BrickField* f, int i) {
+    return (f->row_alive[i / f->cols] >> (i % f->cols)) & 1u;
+}
+
+bool sim_sweep_rect(const SimRect* a, float dx, float dy, const SimRect* b, float* toi, SimAxis* axis);
+void brick_sweep(const BrickField* f, int first, int count, const SimRect* a, float dx, float dy, float* toi, uint8_t* axis);
+
+#endif
@@ -0,0 +1,49 @@
+#include "snapshot.h"
+
+void snapshot_ring_init(SnapshotRing* r, int max_ticks) {
+    r->max_count = max_ticks < 1 ? 1 : max_ticks > SNAPSHOT_SLOTS ? SNAPSHOT_SLOTS : max_ticks;
+    snapshot_ring_clear(r);
+}
+
+void snapshot_ring_clear(SnapshotRing* r) {
+    r->first = 0;
+    r->count = 0;
+    r->write = 0;
+}
+
+static void drop_oldest(SnapshotRing* r) {
+    r->first = (r->first + 1) % SNAPSHOT_SLOTS;
+    r->count -= 1;
+}
+
+bool snapshot_ring_push(SnapshotRing* r, const SimWorld* w) {
+    size_t size = sim_snapshot_size(w);
+    if (size > SNAPSHOT_BYTES) return false;
+    // records never wrap, one that doesn't fit before the end starts over at 0
+    uint32_t at = r->write;
+    if (at + size > SNAPSHOT_BYTES) at = 0;
+
+    // records lie in push order around the ring, so only the oldest ones can be in the way
+    while (r->count > 0) {
+        uint32_t o = r->offset[r->first];
+        bool overlaps = o < at + size && at < o + r->length[r->first];
+        if (!overlaps && r->count < r->max_count) break;
+        drop_oldest(r);
+    }
+
+    int slot = (r->first + r->count) % SNAPSHOT_SLOTS;
+    r->offset[slot] = at;
+    r->length[slot] = (uint32_t)sim_snapshot_save(w, &r->bytes[at]);
+    r->count += 1;
+    r->write = at + r->length[slot];
+    return true;
+}
+
+bool snapshot_ring_rewind(SnapshotRing* r, SimWorld* w, int ticks) {
+    if (ticks < 1 || ticks > r->count) return false;
+    int slot = (r->first + r->count - ticks) % SNAPSHOT_SLOTS;
+    if (!sim_snapshot_restore(w, &r->bytes[r->offset[slot]], r->length[slot])) return false;
+    r->count -= ticks;
+    r->write = r->offset[slot];
+    return true;
+}
@@ -0,0 +1,30 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "sim.h"
+
+#define SNAPSHOT_SLOTS 2048
+#define SNAPSHOT_BYTES (1u << 20)
+
+// The last few seconds of sim_snapshot_save() records, one per tick, packed back to back in a
+// byte ring. Pushing evicts the oldest records that are in the way, so a tick costs one snapshot
+// copy no matter how much history is kept. Multiball snapshots are bigger, the ring then holds
+// fewer ticks rather than allocating
+typedef struct {
+    uint8_t bytes[SNAPSHOT_BYTES];
+    uint32_t offset[SNAPSHOT_SLOTS];
+    uint32_t length[SNAPSHOT_SLOTS];
+    int max_count;      // history limit in ticks, at most SNAPSHOT_SLOTS
+    int first;          // slot of the oldest record
+    int count;
+    uint32_t write;     // byte offset the next record goes to
+} SnapshotRing;
+
+void snapshot_ring_init(SnapshotRing* r, int max_ticks);
+void snapshot_ring_clear(SnapshotRing* r);
+bool snapshot_ring_push(SnapshotRing* r, const SimWorld* w);
+// restores the state from `ticks` pushes ago (1 = the last push) and forgets it and everything
+// newer, so stepping on from there pushes a fresh history. false when the ring is not that deep
+bool snapshot_ring_rewind(SnapshotRing* r, SimWorld* w, int ticks);
+
+#endif
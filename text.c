@@ -0,0 +1,315 @@
+#include "text.h"
+#include "mapped.h"
+#include <stdio.h>
+#include <string.h>
+
+_Static_assert(sizeof(AtlasCacheHeader) % 8 == 0, "cache header is read in place");
+_Static_assert(ATLAS_LAST_GLYPH <= 255, "glyph range is stored in bytes");
+
+const float font_sizes[MAX_FONT_SIZES] = {16, 36};
+
+static const char atlas_cache_magic[4] = {'2', '0', 'G', 'F'};
+
+bool fonts_open(TTF_Font* fonts[MAX_FONT_SIZES], const char* path) {
+    for (int s = 0; s < MAX_FONT_SIZES; s++) fonts[s] = NULL;
+    for (int s = 0; s < MAX_FONT_SIZES; s++) {
+        fonts[s] = TTF_OpenFont(path, font_sizes[s]);
+        if (fonts[s] == NULL) {
+            printf("Error_font: %s\n", SDL_GetError());
+            fonts_close(fonts);
+            return false;
+        }
+    }
+    return true;
+}
+
+void fonts_close(TTF_Font* fonts[MAX_FONT_SIZES]) {
+    for (int s = 0; s < MAX_FONT_SIZES; s++) {
+        if (fonts[s] != NULL) {
+            TTF_CloseFont(fonts[s]);
+            fonts[s] = NULL;
+        }
+    }
+}
+
+// rasterises every glyph of every size and shelf-packs them into one ARGB8888 surface
+static SDL_Surface* bake_atlas(GlyphAtlas* a, TTF_Font* const fonts[MAX_FONT_SIZES]) {
+    static SDL_Surface* baked[MAX_FONT_SIZES][ATLAS_GLYPHS];
+    SDL_Color glyph_colour = {255, 255, 255, 255};
+    SDL_Surface* atlas = NULL;
+    int pen_x = 0;
+    int pen_y = 0;
+    int shelf_h = 0;
+
+    for (int s = 0; s < MAX_FONT_SIZES; s++) {
+        TTF_Font* font = fonts[s];
+        a->sets[s].line_height = (float)TTF_GetFontHeight(font);
+
+        for (int g = 0; g < ATLAS_GLYPHS; g++) {
+            Uint32 ch = ATLAS_FIRST_GLYPH + g;
+            int advance = 0;
+            TTF_GetGlyphMetrics(font, ch, NULL, NULL, NULL, NULL, &advance);
+            a->sets[s].glyphs[g] = (Glyph) {.src = {0, 0, 0, 0}, .advance = (float)advance};
+
+            // blank glyphs (space) have nothing to bake, only an advance
+            baked[s][g] = TTF_RenderGlyph_Blended(font, ch, glyph_colour);
+            SDL_Surface* gs = baked[s][g];
+            if (gs == NULL || gs->w == 0) continue;
+
+            if (pen_x + gs->w > ATLAS_WIDTH) {
+                pen_x = 0;
+                pen_y += shelf_h + 1;
+                shelf_h = 0;
+            }
+            a->sets[s].glyphs[g].src = (SDL_FRect) {.x = pen_x, .y = pen_y, .w = gs->w, .h = gs->h};
+            pen_x += gs->w + 1;
+            if (gs->h > shelf_h) shelf_h = gs->h;
+        }
+    }
+
+    atlas = SDL_CreateSurface(ATLAS_WIDTH, pen_y + shelf_h, SDL_PIXELFORMAT_ARGB8888);
+    if (atlas == NULL) {
+        printf("Error_atlas_surface: %s\n", SDL_GetError());
+    } else {
+        SDL_FillSurfaceRect(atlas, NULL, 0);
+    }
+
+    for (int s = 0; s < MAX_FONT_SIZES; s++) {
+        for (int g = 0; g < ATLAS_GLYPHS; g++) {
+            if (baked[s][g] == NULL) continue;
+            SDL_FRect src = a->sets[s].glyphs[g].src;
+            if (atlas != NULL && src.w > 0) {
+                SDL_Rect dst = {.x = (int)src.x, .y = (int)src.y, .w = (int)src.w, .h = (int)src.h};
+                SDL_SetSurfaceBlendMode(baked[s][g], SDL_BLENDMODE_NONE);
+                SDL_BlitSurface(baked[s][g], NULL, atlas, &dst);
+            }
+            SDL_DestroySurface(baked[s][g]);
+            baked[s][g] = NULL;
+        }
+    }
+    return atlas;
+}
+
+// one texture creation for the whole atlas, whether the pixels were just baked or come from the cache
+static bool upload_atlas(GlyphAtlas* a, SDL_Renderer* renderer, const void* pixels, int w, int h, int pitch) {
+    a->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, w, h);
+    if (a->texture == NULL || !SDL_UpdateTexture(a->texture, NULL, pixels, pitch)) {
+        printf("Error_atlas_texture: %s\n", SDL_GetError());
+        glyph_atlas_destroy(a);
+        return false;
+    }
+    SDL_SetTextureBlendMode(a->texture, SDL_BLENDMODE_BLEND);
+    a->w = (float)w;
+    a->h = (float)h;
+    a->quad_count = 0;
+
+    for (int q = 0; q < MAX_TEXT_QUADS; q++) {
+        int* i = &a->indices[q * 6];
+        int v = q * 4;
+        i[0] = v; i[1] = v + 1; i[2] = v + 2;
+        i[3] = v + 2; i[4] = v + 3; i[5] = v;
+    }
+    return true;
+}
+
+bool glyph_atlas_create(GlyphAtlas* a, SDL_Renderer* renderer, TTF_Font* const fonts[MAX_FONT_SIZES]) {
+    a->texture = NULL;
+    a->quad_count = 0;
+    SDL_Surface* atlas = bake_atlas(a, fonts);
+    if (atlas == NULL) return false;
+    bool ok = upload_atlas(a, renderer, atlas->pixels, atlas->w, atlas->h, atlas->pitch);
+    SDL_DestroySurface(atlas);
+    return ok;
+}
+
+// what a cache baked from this font by this build has to look like; false if the font can't be read
+static bool cache_key(const char* font_path, AtlasCacheHeader* key) {
+    MappedFile font;
+    if (!mapped_open(&font, font_path)) {
+        printf("Error_font: could not read %s\n", font_path);
+        return false;
+    }
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < font.size; i++) {
+        hash ^= font.data[i];
+        hash *= 0x100000001b3ull;
+    }
+    mapped_close(&font);
+
+    memset(key, 0, sizeof(*key));
+    memcpy(key->magic, atlas_cache_magic, sizeof(key->magic));
+    key->version = ATLAS_CACHE_VERSION;
+    key->first_glyph = ATLAS_FIRST_GLYPH;
+    key->last_glyph = ATLAS_LAST_GLYPH;
+    key->font_hash = hash;
+    key->ttf_version = (uint32_t)TTF_Version();
+    key->set_size = sizeof(GlyphSet);
+    memcpy(key->sizes, font_sizes, sizeof(key->sizes));
+    return true;
+}
+
+static bool load_cache(GlyphAtlas* a, SDL_Renderer* renderer, const char* path, const AtlasCacheHeader* key) {
+    MappedFile m;
+    if (!mapped_open(&m, path)) return false;
+
+    // everything but the atlas size has to match the key, the size has to match the file
+    AtlasCacheHeader h;
+    size_t sets_size = sizeof(GlyphSet) * MAX_FONT_SIZES;
+    bool ok = m.size >= sizeof(h) + sets_size;
+    if (ok) {
+        memcpy(&h, m.data, sizeof(h));
+        AtlasCacheHeader match = h;
+        match.w = key->w;
+        match.h = key->h;
+        ok = memcmp(&match, key, sizeof(match)) == 0 && h.w == ATLAS_WIDTH && h.h > 0
+             && m.size == sizeof(h) + sets_size + (size_t)h.w * h.h * 4;
+    }
+    if (ok) {
+        a->texture = NULL;
+        memcpy(a->sets, m.data + sizeof(h), sets_size);
+        ok = upload_atlas(a, renderer, m.data + sizeof(h) + sets_size, (int)h.w, (int)h.h, (int)h.w * 4);
+    }
+    mapped_close(&m);
+    return ok;
+}
+
+// written to a temp file and renamed over the cache like the save, a failure only costs the next start a bake
+static void write_cache(const GlyphAtlas* a, const SDL_Surface* atlas, const char* path, const char* temp_path,
+                        const AtlasCacheHeader* key) {
+    AtlasCacheHeader h = *key;
+    h.w = (uint32_t)atlas->w;
+    h.h = (uint32_t)atlas->h;
+
+    SDL_IOStream* io = SDL_IOFromFile(temp_path, "wb");
+    if (io == NULL) {
+        printf("Error_atlas_cache: %s\n", SDL_GetError());
+        return;
+    }
+    bool ok = SDL_WriteIO(io, &h, sizeof(h)) == sizeof(h) && SDL_WriteIO(io, a->sets, sizeof(a->sets)) == sizeof(a->sets);
+    const uint8_t* row = atlas->pixels;
+    for (int y = 0; ok && y < atlas->h; y++, row += atlas->pitch) {
+        ok = SDL_WriteIO(io, row, (size_t)atlas->w * 4) == (size_t)atlas->w * 4;
+    }
+    ok = ok && SDL_FlushIO(io);
+    if (!SDL_CloseIO(io)) ok = false;
+    if (!ok || !SDL_RenamePath(temp_path, path)) {
+        printf("Error_atlas_cache: could not write %s: %s\n", path, SDL_GetError());
+        SDL_RemovePath(temp_path);
+    }
+}
+
+bool glyph_atlas_load(GlyphAtlas* a, SDL_Renderer* renderer, const char* font_path, bool* cached) {
+    a->texture = NULL;
+    a->quad_count = 0;
+    *cached = false;
+    AtlasCacheHeader key;
+    if (!cache_key(font_path, &key)) return false;
+
+    char* dir = SDL_GetPrefPath("20g", "breakout");
+    char path[1024];
+    char temp_path[1024];
+    SDL_snprintf(path, sizeof(path), "%s%s", dir ? dir : "", ATLAS_CACHE_FILE);
+    SDL_snprintf(temp_path, sizeof(temp_path), "%s%s.tmp", dir ? dir : "", ATLAS_CACHE_FILE);
+    SDL_free(dir);
+
+    if (load_cache(a, renderer, path, &key)) {
+        *cached = true;
+        return true;
+    }
+
+    // a miss, bake from the font like a first run and keep the result for next time
+    TTF_Font* fonts[MAX_FONT_SIZES];
+    if (!TTF_Init()) {
+        printf("Error_ttf_init: %s\n", SDL_GetError());
+        return false;
+    }
+    bool ok = fonts_open(fonts, font_path);
+    SDL_Surface* atlas = ok ? bake_atlas(a, fonts) : NULL;
+    fonts_close(fonts);
+    TTF_Quit();
+    if (atlas == NULL) return false;
+
+    ok = upload_atlas(a, renderer, atlas->pixels, atlas->w, atlas->h, atlas->pitch);
+    if (ok) write_cache(a, atlas, path, temp_path, &key);
+    SDL_DestroySurface(atlas);
+    return ok;
+}
+
+void glyph_atlas_destroy(GlyphAtlas* a) {
+    if (a->texture != NULL) {
+        SDL_DestroyTexture(a->texture);
+        a->texture = NULL;
+    }
+}
+
+static const Glyph* find_glyph(const GlyphSet* set, char c) {
+    unsigned char ch = (unsigned char)c;
+    if (ch < ATLAS_FIRST_GLYPH || ch > ATLAS_LAST_GLYPH) ch = '?';
+    return &set->glyphs[ch - ATLAS_FIRST_GLYPH];
+}
+
+void text_measure(const GlyphAtlas* a, FontSize size, const char* s, float* w, float* h) {
+    const GlyphSet* set = &a->sets[size];
+    float line_w = 0.0f;
+    *w = 0.0f;
+    *h = set->line_height;
+    for (; *s; s++) {
+        if (*s == '\n') {
+            if (s[1] != '\0') *h += set->line_height;
+            line_w = 0.0f;
+            continue;
+        }
+        line_w += find_glyph(set, *s)->advance;
+        if (line_w > *w) *w = line_w;
+    }
+}
+
+// writes the quads for s into out and returns how many; lets callers cache a string's geometry
+int text_build(const GlyphAtlas* a, FontSize size, const char* s, float x, float y, SDL_Color colour, SDL_Vertex* out, int max_quads) {
+    const GlyphSet* set = &a->sets[size];
+    SDL_FColor c = {colour.r / 255.0f, colour.g / 255.0f, colour.b / 255.0f, colour.a / 255.0f};
+    float pen_x = x;
+    float pen_y = y;
+    int quads = 0;
+
+    for (; *s; s++) {
+        if (*s == '\n') {
+            pen_x = x;
+            pen_y += set->line_height;
+            continue;
+        }
+        const Glyph* g = find_glyph(set, *s);
+        if (g->src.w > 0 && quads < max_quads) {
+            SDL_Vertex* v = &out[quads * 4];
+            float u0 = g->src.x / a->w, v0 = g->src.y / a->h;
+            float u1 = (g->src.x + g->src.w) / a->w, v1 = (g->src.y + g->src.h) / a->h;
+            v[0] = (SDL_Vertex) {.position = {pen_x, pen_y}, .color = c, .tex_coord = {u0, v0}};
+            v[1] = (SDL_Vertex) {.position = {pen_x + g->src.w, pen_y}, .color = c, .tex_coord = {u1, v0}};
+            v[2] = (SDL_Vertex) {.position = {pen_x + g->src.w, pen_y + g->src.h}, .color = c, .tex_coord = {u1, v1}};
+            v[3] = (SDL_Vertex) {.position = {pen_x, pen_y + g->src.h}, .color = c, .tex_coord = {u0, v1}};
+            quads += 1;
+        }
+        pen_x += g->advance;
+    }
+    return quads;
+}
+
+void text_queue(GlyphAtlas* a, FontSize size, const char* s, float x, float y, SDL_Color colour) {
+    a->quad_count += text_build(a, size, s, x, y, colour, &a->vertices[a->quad_count * 4], MAX_TEXT_QUADS - a->quad_count);
+}
+
+void text_queue_quads(GlyphAtlas* a, const SDL_Vertex* vertices, int quad_count) {
+    if (quad_count > MAX_TEXT_QUADS - a->quad_count) quad_count = MAX_TEXT_QUADS - a->quad_count;
+    memcpy(&a->vertices[a->quad_count * 4], vertices, sizeof(SDL_Vertex) * 4 * quad_count);
+    a->quad_count += quad_count;
+}
+
+// returns the number of draw calls issued
+int text_flush(GlyphAtlas* a, SDL_Renderer* renderer) {
+    if (a->quad_count == 0) return 0;
+    if (!SDL_RenderGeometry(renderer, a->texture, a->vertices, a->quad_count * 4, a->indices, a->quad_count * 6)) {
+        printf("Error_text_geometry: %s\n", SDL_GetError());
+    }
+    a->quad_count = 0;
+    return 1;
+}
@@ -0,0 +1,77 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+
+#define ATLAS_FIRST_GLYPH 32
+#define ATLAS_LAST_GLYPH 126
+#define ATLAS_GLYPHS (ATLAS_LAST_GLYPH - ATLAS_FIRST_GLYPH + 1)
+#define ATLAS_WIDTH 512
+#define MAX_TEXT_QUADS 256
+#define ATLAS_CACHE_VERSION 1
+#define ATLAS_CACHE_FILE "glyphs.cache"
+
+typedef enum {
+    FONT_SMALL=0,
+    FONT_LARGE,
+    MAX_FONT_SIZES
+} FontSize;
+
+typedef struct {
+    SDL_FRect src;
+    float advance;
+} Glyph;
+
+typedef struct {
+    Glyph glyphs[ATLAS_GLYPHS];
+    float line_height;
+} GlyphSet;
+
+// every glyph of every size baked once into one texture; strings are queued as quads
+// and drawn with a single SDL_RenderGeometry call per flush
+typedef struct {
+    SDL_Texture* texture;
+    float w;
+    float h;
+    GlyphSet sets[MAX_FONT_SIZES];
+    SDL_Vertex vertices[MAX_TEXT_QUADS * 4];
+    int indices[MAX_TEXT_QUADS * 6];
+    int quad_count;
+} GlyphAtlas;
+
+// glyphs.cache sits under the SDL pref path next to save.bin and is mapped and uploaded in place:
+//   AtlasCacheHeader, GlyphSet sets[MAX_FONT_SIZES], then h rows of w ARGB8888 pixels, packed
+// It is only used when the whole header matches what this build would bake, so a different font
+// file, size list, glyph range or SDL_ttf version bakes the atlas again and rewrites the cache
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint8_t first_glyph;
+    uint8_t last_glyph;
+    uint64_t font_hash;         // FNV-1a over the font file
+    uint32_t ttf_version;
+    uint32_t set_size;          // sizeof(GlyphSet)
+    uint32_t w;
+    uint32_t h;
+    float sizes[MAX_FONT_SIZES];
+} AtlasCacheHeader;
+
+extern const float font_sizes[MAX_FONT_SIZES];
+
+// one handle per size, so nothing ever calls TTF_SetFontSize and throws away a glyph cache
+bool fonts_open(TTF_Font* fonts[MAX_FONT_SIZES], const char* path);
+void fonts_close(TTF_Font* fonts[MAX_FONT_SIZES]);
+
+bool glyph_atlas_create(GlyphAtlas* a, SDL_Renderer* renderer, TTF_Font* const fonts[MAX_FONT_SIZES]);
+// the atlas for the font at path, from the cache when it matches and otherwise baked (the fonts
+// are only opened then) and written back to the cache; *cached says which it was
+bool glyph_atlas_load(GlyphAtlas* a, SDL_Renderer* renderer, const char* font_path, bool* cached);
+void glyph_atlas_destroy(GlyphAtlas* a);
+void text_measure(const GlyphAtlas* a, FontSize size, const char* s, float* w, float* h);
+int text_build(const GlyphAtlas* a, FontSize size, const char* s, float x, float y, SDL_Color colour, SDL_Vertex* out, int max_quads);
+void text_queue(GlyphAtlas* a, FontSize size, const char* s, float x, float y, SDL_Color colour);
+void text_queue_quads(GlyphAtlas* a, const SDL_Vertex* vertices, int quad_count);
+int text_flush(GlyphAtlas* a, SDL_Renderer* renderer);
+
+#endif
@@ -0,0 +1,212 @@
+#include "versus.h"
+#include <stdio.h>
+#include <string.h>
+
+enum {
+    VERSUS_HELLO = 1,
+    VERSUS_INPUTS = 2,
+};
+
+#define MOVE_MASK 0x3u  // move_left | move_right, the bits a held key keeps setting
+
+typedef struct {
+    char magic[4];
+    uint8_t version;
+    uint8_t type;
+    uint16_t delay;
+    uint32_t tick_rate;
+    uint32_t reserved;
+    uint64_t seed;
+    uint64_t level_hash;
+} VersusHello;
+
+typedef struct {
+    char magic[4];
+    uint8_t version;
+    uint8_t type;
+    uint16_t count;         // input masks following the header
+    uint32_t ack;           // we hold the receiver's inputs for ticks < ack
+    uint32_t first;         // tick of the first mask
+    uint64_t ping_ns;       // sender clock
+    uint64_t echo_ns;       // the receiver's last ping_ns, 0 before there was one
+    uint64_t held_ns;       // how long the sender sat on echo_ns before sending it back
+    uint32_t sync_tick;
+    uint32_t reserved;
+    uint64_t sync_checksum;
+} VersusInputs;
+
+_Static_assert(sizeof(VersusHello) == 32, "hello is sent as is");
+_Static_assert(sizeof(VersusInputs) == 56, "inputs header is sent as is");
+_Static_assert((VERSUS_WINDOW & (VERSUS_WINDOW - 1)) == 0, "window is indexed with a mask");
+
+static const char versus_magic[4] = {'2', '0', 'G', 'V'};
+
+#define SLOT(t) ((t) & (VERSUS_WINDOW - 1))
+
+void versus_start(Versus* v, NetLink* link, SimWorld* local, uint32_t tick_rate, int delay, uint64_t seed) {
+    memset(v, 0, sizeof(*v));
+    v->link = link;
+    v->local = local;
+    v->tick_rate = tick_rate;
+    // inputs for up to tick + delay must fit the window alongside a full rollback
+    v->delay = delay < 0 ? 0 : delay > VERSUS_WINDOW / 8 ? VERSUS_WINDOW / 8 : delay;
+    v->seed = seed;
+    v->first_wrong = UINT32_MAX;
+    snapshot_ring_init(&v->history, VERSUS_MAX_ROLLBACK + 1);
+}
+
+bool versus_ready(const Versus* v) {
+    return v->connected && v->tick < v->remote_until + VERSUS_MAX_ROLLBACK;
+}
+
+// the opponent keeps holding what it held last; serve and menu presses are one tick only
+static uint8_t predict(const Versus* v) {
+    return v->remote_until > 0 ? v->remote_inputs[SLOT(v->remote_until - 1)] & MOVE_MASK : 0;
+}
+
+static void step_remote(Versus* v, uint32_t t) {
+    snapshot_ring_push(&v->history, &v->remote);
+    uint8_t mask = t < v->remote_until ? v->remote_inputs[SLOT(t)] : predict(v);
+    v->used_inputs[SLOT(t)] = mask;
+    SimInput in = sim_mask_to_input(mask);
+    sim_step(&v->remote, &in, 1.0 / v->tick_rate);
+    if ((t + 1) % VERSUS_SYNC_EVERY == 0) {
+        v->remote_sync[((t + 1) / VERSUS_SYNC_EVERY) % VERSUS_SYNC_SLOTS] = (VersusSync) {t + 1, sim_checksum(&v->remote)};
+    }
+}
+
+uint32_t versus_step(Versus* v, const SimInput* live) {
+    v->local_inputs[SLOT(v->tick + v->delay)] = sim_input_to_mask(live);
+    SimInput in = sim_mask_to_input(v->local_inputs[SLOT(v->tick)]);
+    uint32_t events = sim_step(v->local, &in, 1.0 / v->tick_rate);
+    step_remote(v, v->tick);
+    v->tick += 1;
+    if (v->tick % VERSUS_SYNC_EVERY == 0) v->local_sync = (VersusSync) {v->tick, sim_checksum(v->local)};
+    return events;
+}
+
+static bool on_hello(Versus* v, const VersusHello* h) {
+    if (h->version != VERSUS_VERSION || h->tick_rate != v->tick_rate || h->level_hash != v->local->bricks.level_hash) {
+        printf("Error_versus: peer runs version %u at %u Hz on level %016llx, we run version %u at %u Hz on %016llx\n",
+               h->version, h->tick_rate, (unsigned long long)h->level_hash, VERSUS_VERSION, v->tick_rate,
+               (unsigned long long)v->local->bricks.level_hash);
+        return false;
+    }
+    if (v->connected) return true;
+
+    // both sides end up with the same seed and the larger of the two delays
+    if (h->delay > v->delay) v->delay = h->delay;
+    sim_seed(v->local, v->seed ^ h->seed);
+    v->remote = *v->local;
+    v->remote_until = (uint32_t)v->delay;
+    v->connected = true;
+    printf("versus: connected, input delay %d ticks\n", v->delay);
+    return true;
+}
+
+static void on_inputs(Versus* v, const VersusInputs* h, const uint8_t* masks, uint64_t now_ns) {
+    v->peer_connected = true;
+    if (h->ack > v->acked && h->ack <= v->tick + v->delay) v->acked = h->ack;
+    if (h->echo_ns != 0 && now_ns >= h->echo_ns + h->held_ns) {
+        double rtt = (double)(now_ns - h->echo_ns - h->held_ns) / 1e6;
+        v->stats.rtt_ms = v->stats.rtt_ms > 0.0 ? v->stats.rtt_ms * 0.875 + rtt * 0.125 : rtt;
+    }
+    v->peer_ping_ns = h->ping_ns;
+    v->peer_ping_at = now_ns;
+
+    // only take inputs that continue the ones we have, a gap is filled by a later resend
+    uint32_t end = h->first + h->count;
+    if (h->first <= v->remote_until) {
+        for (uint32_t t = v->remote_until; t < end && t < v->tick + VERSUS_WINDOW / 2; t++) {
+            uint8_t mask = masks[t - h->first];
+            v->remote_inputs[SLOT(t)] = mask;
+            if (t < v->tick && v->used_inputs[SLOT(t)] != mask && t < v->first_wrong) v->first_wrong = t;
+            v->remote_until = t + 1;
+        }
+    }
+    if (h->sync_tick > v->peer_sync.tick) v->peer_sync = (VersusSync) {h->sync_tick, h->sync_checksum};
+}
+
+// once every input up to the peer's sync tick is known our copy of its board is final there
+static void check_sync(Versus* v) {
+    const VersusSync* p = &v->peer_sync;
+    if (p->tick <= v->sync_checked || p->tick > v->remote_until || p->tick > v->tick) return;
+    v->sync_checked = p->tick;
+    const VersusSync* mine = &v->remote_sync[(p->tick / VERSUS_SYNC_EVERY) % VERSUS_SYNC_SLOTS];
+    if (mine->tick != p->tick) return;
+    v->stats.sync_checks += 1;
+    if (mine->checksum != p->checksum && v->stats.desync_tick == 0) {
+        v->stats.desync_tick = p->tick;
+        printf("Error_versus: boards diverged by tick %u, are both sides the same build?\n", p->tick);
+    }
+}
+
+bool versus_poll(Versus* v, uint64_t now_ns) {
+    uint8_t buffer[NET_MAX_PACKET];
+    int size;
+    while ((size = net_recv(v->link, buffer, sizeof(buffer), now_ns)) > 0) {
+        if (size < 6 || memcmp(buffer, versus_magic, sizeof(versus_magic)) != 0) continue;
+        v->stats.packets_received += 1;
+        if (buffer[5] == VERSUS_HELLO && size >= (int)sizeof(VersusHello)) {
+            VersusHello h;
+            memcpy(&h, buffer, sizeof(h));
+            if (!on_hello(v, &h)) return false;
+        } else if (buffer[5] == VERSUS_INPUTS && buffer[4] == VERSUS_VERSION && v->connected && size >= (int)sizeof(VersusInputs)) {
+            VersusInputs h;
+            memcpy(&h, buffer, sizeof(h));
+            if (size - (int)sizeof(h) >= h.count) on_inputs(v, &h, buffer + sizeof(h), now_ns);
+        }
+    }
+
+    if (v->first_wrong < v->tick) {
+        int depth = (int)(v->tick - v->first_wrong);
+        // depth is at most VERSUS_MAX_ROLLBACK, which the ring always holds
+        snapshot_ring_rewind(&v->history, &v->remote, depth);
+        for (uint32_t t = v->first_wrong; t < v->tick; t++) step_remote(v, t);
+        v->stats.rollbacks += 1;
+        v->stats.rollback_depth = depth;
+        if (depth > v->stats.max_rollback_depth) v->stats.max_rollback_depth = depth;
+        v->stats.resim_ticks += (uint64_t)depth;
+    }
+    v->first_wrong = UINT32_MAX;
+    check_sync(v);
+    return true;
+}
+
+void versus_send(Versus* v, uint64_t now_ns) {
+    uint8_t packet[NET_MAX_PACKET];
+    if (!v->connected || !v->peer_connected) {
+        VersusHello h = {
+            .version = VERSUS_VERSION,
+            .type = VERSUS_HELLO,
+            .delay = (uint16_t)v->delay,
+            .tick_rate = v->tick_rate,
+            .seed = v->seed,
+            .level_hash = v->local->bricks.level_hash,
+        };
+        memcpy(h.magic, versus_magic, sizeof(h.magic));
+        if (net_send(v->link, &h, sizeof(h), now_ns)) v->stats.packets_sent += 1;
+    }
+    if (!v->connected) return;
+
+    // local inputs are known up to tick + delay; resend everything the peer hasn't acknowledged
+    uint32_t known = v->tick + (uint32_t)v->delay;
+    uint32_t count = known - v->acked;
+    if (count > VERSUS_PACKET_INPUTS) count = VERSUS_PACKET_INPUTS;
+    VersusInputs h = {
+        .version = VERSUS_VERSION,
+        .type = VERSUS_INPUTS,
+        .count = (uint16_t)count,
+        .ack = v->remote_until,
+        .first = v->acked,
+        .ping_ns = now_ns,
+        .echo_ns = v->peer_ping_ns,
+        .held_ns = v->peer_ping_ns ? now_ns - v->peer_ping_at : 0,
+        .sync_tick = v->local_sync.tick,
+        .sync_checksum = v->local_sync.checksum,
+    };
+    memcpy(h.magic, versus_magic, sizeof(h.magic));
+    memcpy(packet, &h, sizeof(h));
+    for (uint32_t i = 0; i < count; i++) packet[sizeof(h) + i] = v->local_inputs[SLOT(v->acked + i)];
+    if (net_send(v->link, packet, (int)(sizeof(h) + count), now_ns)) v->stats.packets_sent += 1;
+}
@@ -0,0 +1,87 @@
+#ifndef VERSUS_H
+#define VERSUS_H
+
+#include "sim.h"
+#include "net.h"
+#include "snapshot.h"
+
+#define VERSUS_VERSION 1
+#define VERSUS_PORT 20200
+#define VERSUS_DELAY 2              // default input delay in ticks, hides up to ~2 ticks of one-way latency
+#define VERSUS_WINDOW 256           // ticks of input kept on each side, a power of two
+#define VERSUS_MAX_ROLLBACK 16      // ticks the opponent may be predicted ahead before the sim waits
+#define VERSUS_PACKET_INPUTS 64     // most inputs resent in one packet
+#define VERSUS_SYNC_EVERY 64        // ticks between checksums exchanged to catch desyncs
+#define VERSUS_SYNC_SLOTS 8
+
+// Two players each clear their own copy of the same board (same level, same seed) and race for
+// points. Every instance steps both boards from per-tick inputs: its own with the local input
+// delayed by `delay` ticks, the opponent's with the inputs received over the link. When those
+// have not arrived yet the opponent's last input is predicted to continue; a snapshot is pushed
+// before each predicted tick, and once the real inputs turn out different the opponent's board
+// is rolled back to the first wrong tick and stepped forward again. More than
+// VERSUS_MAX_ROLLBACK predicted ticks and the sim waits for the peer instead (plain lockstep).
+// The sim is deterministic for a given build, so both instances must run the same binary
+//
+// packets: "20GV", u8 version, u8 type, then the VersusHello or VersusInputs fields as they
+// sit in memory (little endian). Inputs are SimInput masks and every packet repeats all inputs
+// the peer has not acknowledged yet, so losing packets only costs latency
+typedef struct {
+    double rtt_ms;              // smoothed round trip time
+    int rollback_depth;         // ticks re-simulated by the last correction
+    int max_rollback_depth;
+    uint64_t rollbacks;
+    uint64_t resim_ticks;
+    uint64_t resim_ns;          // caller measured time spent in versus_poll corrections
+    uint64_t stalls;            // frames the sim waited on the peer
+    uint64_t packets_sent;
+    uint64_t packets_received;
+    uint64_t sync_checks;
+    uint32_t desync_tick;       // first checksum tick that disagreed, 0 while in sync
+} VersusStats;
+
+typedef struct {
+    uint32_t tick;
+    uint64_t checksum;
+} VersusSync;
+
+typedef struct {
+    NetLink* link;
+    SimWorld* local;            // this player's board, stepped by versus_step
+    SimWorld remote;            // the opponent's board, up to VERSUS_MAX_ROLLBACK ticks predicted
+    SnapshotRing history;       // opponent states before each tick not yet confirmed
+    uint8_t local_inputs[VERSUS_WINDOW];    // masks by tick % VERSUS_WINDOW
+    uint8_t remote_inputs[VERSUS_WINDOW];
+    uint8_t used_inputs[VERSUS_WINDOW];     // what the opponent's board was actually stepped with
+    uint32_t tick;              // next tick both boards step
+    uint32_t remote_until;      // opponent inputs known for ticks < remote_until
+    uint32_t acked;             // peer holds our inputs for ticks < acked
+    uint32_t first_wrong;       // earliest mispredicted tick, UINT32_MAX when none
+    uint32_t tick_rate;
+    int delay;
+    uint64_t seed;              // our half, the boards use ours ^ theirs
+    bool connected;             // we have the peer's hello
+    bool peer_connected;        // the peer has ours, it is sending inputs
+    uint64_t peer_ping_ns;      // peer clock from its last packet, echoed back for rtt
+    uint64_t peer_ping_at;      // our clock when that packet came in
+    VersusSync local_sync;      // latest checksum of our board, sent to the peer
+    VersusSync remote_sync[VERSUS_SYNC_SLOTS];  // our copy of the peer's board at sync ticks
+    VersusSync peer_sync;       // the peer's latest checksum of its own board
+    uint32_t sync_checked;      // last sync tick compared
+    VersusStats stats;
+} Versus;
+
+// local must already hold the level; both boards are reseeded once the peer answers
+void versus_start(Versus* v, NetLink* link, SimWorld* local, uint32_t tick_rate, int delay, uint64_t seed);
+// reads every packet that has arrived and corrects the opponent's board if a prediction was
+// wrong; false when the peer can't be played against. Call once a frame before stepping
+bool versus_poll(Versus* v, uint64_t now_ns);
+// false while waiting for the peer to connect or to catch up
+bool versus_ready(const Versus* v);
+// steps both boards one tick of 1/tick_rate, `live` is this tick's local input and is applied
+// `delay` ticks from now; returns the local board's SIM_EVENT_* flags
+uint32_t versus_step(Versus* v, const SimInput* live);
+// sends our unacknowledged inputs (and the hello until the peer has it), once a frame after stepping
+void versus_send(Versus* v, uint64_t now_ns);
+
+#endif